@@ -0,0 +1,274 @@
+// Headless benchmark of the render loop: runs the same simulation and
+// drawing code as game() for a fixed number of frames, following a scripted
+// camera path, inside an offscreen EGL context (Mesa's surfaceless platform
+// works without any display, e.g. with llvmpipe on CI). The results are
+// printed as JSON.
+//
+// Usage: MineGLBench [frames] [width] [height] [output.json]
+// MINEGL_HERD=<count> adds that many cows to the scene.
+// MINEGL_EDITS=<count> digs that many blocks every frame, and reports the
+// latency from edit to the frame showing it.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <glad/glad.h>
+
+#include "gl_extensions.hpp"
+#include "globals.hpp"
+#include "profiler.hpp"
+#include "renderer.hpp"
+#include "world.hpp"
+
+#define BENCH_SEED 1234
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static EGLDisplay getDisplay(){
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if (getPlatformDisplay != NULL){
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) return display;
+    }
+
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) return display;
+
+    return EGL_NO_DISPLAY;
+}
+
+// Creates an OpenGL 3.3 core context without any surface
+static bool createOffscreenContext(){
+    EGLDisplay display = getDisplay();
+
+    if (display == EGL_NO_DISPLAY){
+        fprintf(stderr, "ERROR: No EGL display available.\n");
+        return false;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+
+    EGLConfig config = NULL;
+    EGLint configs = 0;
+    eglChooseConfig(display, configAttributes, &config, 1, &configs);
+
+    eglBindAPI(EGL_OPENGL_API);
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    EGLContext context = eglCreateContext(display, configs > 0 ? config : NULL, EGL_NO_CONTEXT, contextAttributes);
+
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)){
+        fprintf(stderr, "ERROR: Cannot create an offscreen OpenGL context (0x%x).\n", eglGetError());
+        return false;
+    }
+
+    return true;
+}
+
+static GLuint createFramebuffer(int width, int height){
+    GLuint renderbuffers[2];
+    glGenRenderbuffers(2, renderbuffers);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) return 0;
+
+    glViewport(0, 0, width, height);
+
+    return framebuffer;
+}
+
+// Digs "count" blocks, each one further down a column picked in a fixed
+// pseudo random order
+static void digBlocks(World& world, int frame, int count){
+    static int depths[MAP_SIZE][MAP_SIZE] = {};
+
+    for (int k = 0; k < count; k++){
+        int edit = frame * count + k;
+        int i = (edit * 7) % MAP_SIZE;
+        int j = (edit * 13 + edit / MAP_SIZE) % MAP_SIZE;
+
+        glm::vec4 surface = mapData[i][j];
+        world.setBlock(glm::ivec3((int) surface.x, (int) surface.y - depths[i][j], (int) surface.z), air);
+        depths[i][j]++;
+    }
+}
+
+// Orbits the center of the map while looking at it
+static void placeCamera(int frame, int frames){
+    const float radius = 24.0f;
+    float angle = 2.0f * 3.141592f * frame / frames;
+
+    glm::vec4 position = glm::vec4(radius * sin(angle), 0.0f, radius * cos(angle), 1.0f);
+
+    camera.setFreePose(position, 0.45f, angle);
+}
+
+int main(int argc, char** argv){
+    int frames = argc > 1 ? atoi(argv[1]) : 600;
+    int width = argc > 2 ? atoi(argv[2]) : 800;
+    int height = argc > 3 ? atoi(argv[3]) : 800;
+    const char* outputFilename = argc > 4 ? argv[4] : NULL;
+
+    if (frames <= 0 || width <= 0 || height <= 0){
+        fprintf(stderr, "Usage: %s [frames] [width] [height] [output.json]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The loaders log to stdout; keep it for the JSON results only
+    fflush(stdout);
+    int standardOutput = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+
+    if (!createOffscreenContext()) return EXIT_FAILURE;
+
+    gladLoadGLLoader((GLADloadproc)eglGetProcAddress);
+    loadGlExtensions((GLADloadproc)eglGetProcAddress);
+
+    if (createFramebuffer(width, height) == 0){
+        fprintf(stderr, "ERROR: Cannot create the offscreen framebuffer.\n");
+        return EXIT_FAILURE;
+    }
+
+    camera.updateScreenRatio((float) width / height);
+
+    auto startupStart = std::chrono::steady_clock::now();
+
+    Profiler profiler;
+
+    Renderer renderer = Renderer(profiler);
+    World world = World(BENCH_SEED, profiler);
+
+    const char* herd = getenv("MINEGL_HERD");
+    if (herd != NULL) world.spawnHerd(atoi(herd));
+
+    const char* edits = getenv("MINEGL_EDITS");
+    int editsPerFrame = edits != NULL ? atoi(edits) : 0;
+
+    double startupTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+
+    int finishPhase = profiler.addPhase("finish", false);
+
+    fflush(stdout);
+    dup2(standardOutput, STDOUT_FILENO);
+    close(standardOutput);
+
+    SampleWindow frameTimes = SampleWindow(frames);
+    double totalTime = 0.0;
+    double minTime = 1.0e9;
+    double maxTime = 0.0;
+    RenderStats stats;
+
+    for (int frame = 0; frame < frames; frame++){
+        auto frameStart = std::chrono::steady_clock::now();
+
+        profiler.beginFrame();
+
+        placeCamera(frame, frames);
+
+        if (editsPerFrame > 0) digBlocks(world, frame, editsPerFrame);
+
+        // One simulation tick per frame keeps runs deterministic
+        world.tick();
+
+        renderer.updateTerrain(world.getChunkMeshes());
+        renderer.render(camera.getProjection(), world.getCurrentState());
+
+        // There is no swap offscreen, so wait for the GPU to really finish
+        {
+            ScopedTimer timer(profiler, finishPhase);
+            glFinish();
+        }
+
+        profiler.endFrame();
+
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+
+        frameTimes.add(elapsed);
+        totalTime += elapsed;
+        if (elapsed < minTime) minTime = elapsed;
+        if (elapsed > maxTime) maxTime = elapsed;
+
+        stats = renderer.getStats();
+    }
+
+    FILE* output = stdout;
+
+    if (outputFilename != NULL){
+        output = fopen(outputFilename, "w");
+
+        if (output == NULL){
+            fprintf(stderr, "ERROR: Cannot open file \"%s\".\n", outputFilename);
+            return EXIT_FAILURE;
+        }
+    }
+
+    fprintf(output, "{\"renderer\":\"%s\",\"version\":\"%s\",", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+    fprintf(output, "\"frames\":%d,\"width\":%d,\"height\":%d,\"startup_ms\":%.3f,", frames, width, height, startupTime);
+    fprintf(output, "\"entities\":%zu,\"draw_calls\":%ld,\"triangles\":%ld,", world.getEntityCount(), stats.drawCalls, stats.triangles);
+    fprintf(output, "\"visible_chunks\":%ld,\"chunk_meshes\":%zu,", stats.visibleChunks, renderer.getChunkMeshCount());
+    fprintf(output, "\"block_bytes\":%zu,", world.getBlockMemory());
+
+    MeshMemoryStats meshMemory = renderer.getMeshMemoryStats();
+    fprintf(output, "\"mesh_memory\":{\"pages\":%ld,\"used_bytes\":%zu,\"allocated_bytes\":%zu,\"capacity_bytes\":%zu,",
+            meshMemory.pages, meshMemory.usedBytes, meshMemory.allocatedBytes, meshMemory.capacityBytes);
+    fprintf(output, "\"fragmentation\":%.4f,\"defragmentations\":%ld},", meshMemory.fragmentation, meshMemory.defragmentations);
+
+    const GeneratorTimings& generation = world.getGenerationTimings();
+    fprintf(output, "\"generation_ms\":{\"chunks\":%ld,\"wall\":%.3f", generation.chunks, generation.wallMilliseconds);
+
+    for (int stage = 0; stage < GENERATOR_STAGES; stage++){
+        fprintf(output, ",\"%s\":%.3f", generatorStageNames[stage], generation.stageMilliseconds[stage]);
+    }
+
+    fprintf(output, "},");
+    fprintf(output, "\"frame_ms\":{\"mean\":%.4f,\"min\":%.4f,\"max\":%.4f,\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f},",
+            totalTime / frames, minTime, maxTime, frameTimes.percentile(50), frameTimes.percentile(95), frameTimes.percentile(99));
+
+    if (editsPerFrame > 0){
+        const SampleWindow& latencies = renderer.getEditLatencies();
+
+        fprintf(output, "\"edit_ms\":{\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f},",
+                latencies.percentile(50), latencies.percentile(95), latencies.percentile(99));
+    }
+
+    fprintf(output, "\"phases_ms\":");
+    profiler.reportJson(output);
+    fprintf(output, "}\n");
+
+    if (output != stdout) fclose(output);
+
+    return 0;
+}
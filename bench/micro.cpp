@@ -0,0 +1,644 @@
+// Microbenchmarks of the CPU hot paths. Needs neither a window nor an OpenGL
+// context. Every benchmark runs a fixed number of iterations per repetition,
+// so results are comparable between runs and machines; the minimum, median
+// and mean time per operation over the repetitions are printed as JSON.
+//
+// Usage: MineGLMicrobench [filter] [output.json]
+// Only benchmarks whose name contains "filter" are run.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bezier.hpp"
+#include "buddy_allocator.hpp"
+#include "chunk_mesher.hpp"
+#include "collisions.hpp"
+#include "entities.hpp"
+#include "generation_cache.hpp"
+#include "globals.hpp"
+#include "light_engine.hpp"
+#include "obj_loader.hpp"
+#include "perlin_noise.hpp"
+#include "region_file.hpp"
+#include "spatial_hash.hpp"
+#include "std/matrices.h"
+#include "terrain_generator.hpp"
+#include "voxel_grid.hpp"
+#include "world.hpp"
+#include "world_storage.hpp"
+
+#define REPETITIONS 7
+#define MICRO_SEED 1234
+
+struct BenchmarkResult {
+    std::string name;
+    long operations;
+    double minimum;
+    double median;
+    double mean;
+};
+
+static std::vector<BenchmarkResult> results;
+static const char* filter = "";
+
+// Keeps the compiler from optimizing away a value nobody reads
+template <typename T>
+static inline void doNotOptimize(const T& value){
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Runs "body" (which receives the iteration index) "iterations" times per
+// repetition, after one untimed warm up repetition, and records the time per
+// operation in nanoseconds. "operations" is how many operations one call of
+// "body" counts as.
+template <typename F>
+static void benchmark(const char* name, long iterations, long operations, F body){
+    if (strstr(name, filter) == NULL) return;
+
+    for (long i = 0; i < iterations; i++) body(i);
+
+    std::vector<double> samples;
+
+    for (int repetition = 0; repetition < REPETITIONS; repetition++){
+        auto start = std::chrono::steady_clock::now();
+
+        for (long i = 0; i < iterations; i++) body(i);
+
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        samples.push_back(elapsed / (iterations * operations));
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    double mean = 0.0;
+    for (double sample : samples) mean += sample / samples.size();
+
+    results.push_back({name, iterations * operations, samples.front(), samples[samples.size() / 2], mean});
+
+    fprintf(stderr, "%-32s %14.1f ns/op\n", name, samples[samples.size() / 2]);
+}
+
+static void benchmarkPerlinNoise(){
+    benchmark("perlin_noise/generate_64x64", 20, 1, [](long){
+        PerlinNoise pn = PerlinNoise(MAP_SIZE, MAP_SIZE, MICRO_SEED);
+        doNotOptimize(pn.generateNoise(6));
+    });
+}
+
+static void benchmarkObjModel(){
+    benchmark("obj_model/load_cow", 3, 1, [](long){
+        ObjModel model("assets/cow.obj");
+        doNotOptimize(model);
+    });
+
+    benchmark("obj_model/load_and_normals_cow", 3, 1, [](long){
+        ObjModel model("assets/cow.obj");
+        model.ComputeNormals();
+        doNotOptimize(model);
+    });
+
+    benchmark("obj_model/load_and_normals_leaf", 50, 1, [](long){
+        ObjModel model("assets/leaf.obj");
+        model.ComputeNormals();
+        doNotOptimize(model);
+    });
+}
+
+static void benchmarkMatrices(){
+    const int count = 1024;
+    std::mt19937 random(MICRO_SEED);
+    std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+
+    std::vector<glm::vec4> vectors(count);
+    for (glm::vec4& v : vectors) v = glm::vec4(distribution(random), distribution(random), distribution(random), 1.0f);
+
+    benchmark("matrices/translate", 1000, count, [&](long){
+        for (int i = 0; i < count; i++) doNotOptimize(Matrix_Translate(vectors[i].x, vectors[i].y, vectors[i].z));
+    });
+
+    benchmark("matrices/rotate_y", 1000, count, [&](long){
+        for (int i = 0; i < count; i++) doNotOptimize(Matrix_Rotate_Y(vectors[i].x));
+    });
+
+    benchmark("matrices/rotate_axis", 500, count, [&](long){
+        for (int i = 0; i < count; i++) doNotOptimize(Matrix_Rotate(vectors[i].w, vectors[i] - glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+    });
+
+    benchmark("matrices/camera_view", 200, count, [&](long){
+        glm::vec4 up = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+        for (int i = 0; i < count; i++) doNotOptimize(Matrix_Camera_View(vectors[i], vectors[(i + 1) % count] - vectors[i], up));
+    });
+
+    benchmark("matrices/perspective", 100, count, [&](long){
+        for (int i = 0; i < count; i++) doNotOptimize(Matrix_Perspective(1.0f, 1.0f + vectors[i].x * 0.01f, -0.1f, -50.0f));
+    });
+
+    benchmark("matrices/translate_times_rotate", 100, count, [&](long){
+        for (int i = 0; i < count; i++){
+            doNotOptimize(Matrix_Translate(vectors[i].x, vectors[i].y, vectors[i].z) * Matrix_Rotate_Y(vectors[i].w));
+        }
+    });
+
+    benchmark("matrices/crossproduct_norm", 1000, count, [&](long){
+        for (int i = 0; i < count; i++) doNotOptimize(norm(crossproduct(vectors[i], vectors[(i + 1) % count])));
+    });
+}
+
+static void benchmarkBezier(){
+    const int count = 1024;
+    BezierCurve bezier = BezierCurve();
+
+    glm::vec4 p0 = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec4 p1 = glm::vec4(10.0f, -4.0f, 0.0f, 0.0f);
+    glm::vec4 c0 = glm::vec4(-10.0f, -6.0f, 0.0f, 0.0f);
+    glm::vec4 c1 = glm::vec4(0.0f, -10.0f, 0.0f, 0.0f);
+
+    benchmark("bezier/calculate", 200, count, [&](long){
+        for (int i = 0; i < count; i++) doNotOptimize(bezier.calculate(p0, p1, c0, c1, (float) i / count));
+    });
+
+    // Curves around the one above, as a herd of path followers would use
+    const int curves = 10000;
+    std::mt19937 random(MICRO_SEED);
+    std::uniform_real_distribution<float> jitter(-2.0f, 2.0f);
+
+    BezierBatch batch;
+    for (int i = 0; i < curves; i++){
+        glm::vec4 offset = glm::vec4(jitter(random), jitter(random), jitter(random), 0.0f);
+        batch.add(p0 + offset, p1 + offset, c0 + offset, c1 + offset);
+    }
+
+    std::vector<float> parameters(curves);
+    for (int i = 0; i < curves; i++) parameters[i] = (float) i / curves;
+
+    std::vector<float> x(curves), y(curves), z(curves);
+
+    benchmark("bezier/batch_evaluate_10000", 200, curves, [&](long){
+        batch.evaluate(parameters.data(), x.data(), y.data(), z.data());
+        doNotOptimize(x[0]);
+    });
+
+    std::vector<float> arcParameters(curves);
+
+    benchmark("bezier/batch_evaluate_at_distance_10000", 200, curves, [&](long){
+        batch.getParametersAtDistance(parameters.data(), arcParameters.data());
+        batch.evaluate(arcParameters.data(), x.data(), y.data(), z.data());
+        doNotOptimize(x[0]);
+    });
+}
+
+// The terrain World generated "mapData" from
+static void buildVoxels(VoxelGrid& voxels){
+    std::vector<glm::ivec3> chunks;
+    voxels.listChunks(chunks);
+
+    std::vector<std::unique_ptr<Chunk>> generated;
+    GeneratorTimings timings;
+    generateChunks(TerrainGenerator(MICRO_SEED), chunks, generated, timings);
+
+    for (size_t i = 0; i < chunks.size(); i++) voxels.replaceChunk(chunks[i], std::move(generated[i]));
+}
+
+static void benchmarkCollisions(){
+    const int count = 1024;
+    std::mt19937 random(MICRO_SEED);
+    std::uniform_real_distribution<float> horizontal(-MAP_SIZE / 2.0f, MAP_SIZE / 2.0f);
+    std::uniform_real_distribution<float> vertical(-25.0f, 0.0f);
+
+    std::vector<glm::vec4> positions(count);
+    for (glm::vec4& p : positions) p = glm::vec4(horizontal(random), vertical(random), horizontal(random), 1.0f);
+
+    VoxelGrid voxels = VoxelGrid(glm::ivec3(-MAP_SIZE / 2, -48, -MAP_SIZE / 2), glm::ivec3(MAP_SIZE, 64, MAP_SIZE));
+    buildVoxels(voxels);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+    std::vector<glm::vec3> steps(count);
+    for (glm::vec3& step : steps) step = glm::normalize(glm::vec3(direction(random), direction(random), direction(random)));
+
+    // One tick of the camera at its usual speed, then a 50 m hitch that
+    // crosses the whole map
+    for (float length : {0.1f, 50.0f}){
+        std::string name = length < 1.0f ? "collisions/sweep_camera_step" : "collisions/sweep_camera_long";
+
+        benchmark(name.c_str(), length < 1.0f ? 1000 : 50, count, [&](long){
+            for (int i = 0; i < count; i++){
+                glm::vec3 eye = glm::vec3(positions[i]);
+                Aabb body = {eye - glm::vec3(0.3f, 1.5f, 0.3f), eye + glm::vec3(0.3f, 0.2f, 0.3f)};
+                doNotOptimize(sweepAabb(voxels, body, steps[i] * length));
+            }
+        });
+    }
+}
+
+// Rays from the height of the camera, both short picking rays and long ones
+// crossing the whole map
+static void benchmarkRaycasts(){
+    const int count = 1024;
+    VoxelGrid voxels = VoxelGrid(glm::ivec3(-MAP_SIZE / 2, -48, -MAP_SIZE / 2), glm::ivec3(MAP_SIZE, 64, MAP_SIZE));
+    buildVoxels(voxels);
+
+    std::mt19937 random(MICRO_SEED);
+    std::uniform_real_distribution<float> horizontal(-MAP_SIZE / 2.0f, MAP_SIZE / 2.0f);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+    std::vector<glm::vec3> origins(count);
+    std::vector<glm::vec3> directions(count);
+    std::vector<RaycastHit> hits(count);
+
+    for (int i = 0; i < count; i++){
+        origins[i] = glm::vec3(horizontal(random), -5.0f, horizontal(random));
+        directions[i] = glm::vec3(direction(random), direction(random) - 0.5f, direction(random));
+    }
+
+    benchmark("raycast/pick_8", 1000, count, [&](long){
+        for (int i = 0; i < count; i++) doNotOptimize(raycast(voxels, origins[i], directions[i], 8.0f));
+    });
+
+    benchmark("raycast/batch_100", 200, count, [&](long){
+        raycastBatch(voxels, origins.data(), directions.data(), count, 100.0f, hits.data());
+        doNotOptimize(hits[0]);
+    });
+
+    benchmark("raycast/line_of_sight", 1000, count, [&](long){
+        for (int i = 0; i < count; i++) doNotOptimize(hasLineOfSight(voxels, origins[i], origins[(i + 1) % count]));
+    });
+}
+
+// Meshing the whole map, then one edit and the chunks it dirties
+static void benchmarkTerrain(){
+    VoxelGrid voxels = VoxelGrid(glm::ivec3(-MAP_SIZE / 2, -48, -MAP_SIZE / 2), glm::ivec3(MAP_SIZE, 64, MAP_SIZE));
+    buildVoxels(voxels);
+
+    LightEngine lights(voxels);
+    lights.relightAll();
+
+    ChunkMesher mesher;
+    ChunkMesh mesh;
+    std::vector<glm::ivec3> chunks;
+    voxels.takeDirtyChunks(chunks);
+
+    // A chunk crossing the surface goes through every stage, one deep in
+    // the ground skips none but carves the most caves
+    TerrainGenerator generator = TerrainGenerator(MICRO_SEED);
+    double stageMilliseconds[GENERATOR_STAGES] = {};
+
+    for (glm::ivec3 chunk : {getChunkOf(glm::ivec3(4, (int) mapData[36][36].y, 4)), glm::ivec3(0, -3, 0)}){
+        std::string name = chunk.y == -3 ? "terrain/generate_deep_chunk" : "terrain/generate_surface_chunk";
+
+        benchmark(name.c_str(), 20, 1, [&](long){
+            Chunk blocks;
+            generator.generate(chunk, blocks, stageMilliseconds);
+            doNotOptimize(blocks);
+        });
+    }
+
+    // Copies out of the cache instead, from memory, then from a spill
+    // directory when nothing fits in memory
+    Chunk surface;
+    glm::ivec3 surfaceChunk = getChunkOf(glm::ivec3(4, (int) mapData[36][36].y, 4));
+    generator.generate(surfaceChunk, surface, stageMilliseconds);
+
+    std::filesystem::path spillDirectory = std::filesystem::temp_directory_path() / "MineGLMicrobenchCache";
+    std::filesystem::remove_all(spillDirectory);
+
+    for (size_t capacity : {(size_t) GENERATION_CACHE_CAPACITY, (size_t) 0}){
+        GenerationCache cache(capacity, spillDirectory.c_str());
+        cache.insert(MICRO_SEED, surfaceChunk, &surface);
+
+        std::string name = capacity > 0 ? "terrain/cache_hit" : "terrain/cache_disk_hit";
+        std::unique_ptr<Chunk> blocks;
+
+        benchmark(name.c_str(), 200, 1, [&](long){
+            cache.find(MICRO_SEED, surfaceChunk, blocks);
+            doNotOptimize(blocks);
+        });
+    }
+
+    std::filesystem::remove_all(spillDirectory);
+
+    benchmark("terrain/mesh_all_chunks", 20, 1, [&](long){
+        for (glm::ivec3 chunk : chunks){
+            mesher.mesh(voxels, lights, chunk, mesh);
+            doNotOptimize(mesh.indices.size());
+        }
+    });
+
+    // A block at a chunk corner dirties three neighbours too
+    for (glm::ivec3 block : {glm::ivec3(4, (int) mapData[36][36].y, 4), glm::ivec3(0, -32, 0)}){
+        std::string name = block.x == 0 ? "terrain/edit_remesh_corner" : "terrain/edit_remesh";
+        std::vector<glm::ivec3> dirty;
+        Block original = voxels.getBlock(block);
+
+        benchmark(name.c_str(), 200, 1, [&](long i){
+            voxels.setBlock(block, i % 2 == 0 ? (Block) air : original);
+            lights.blockChanged(block);
+            lights.propagate();
+            voxels.takeDirtyChunks(dirty);
+
+            for (glm::ivec3 chunk : dirty){
+                mesher.mesh(voxels, lights, chunk, mesh);
+                doNotOptimize(mesh.indices.size());
+            }
+        });
+    }
+}
+
+// Worst cases of the light engine: a hall of 56x24x56 blocks of air buried
+// under the ground, lit by a torch in the middle and by the sky through a
+// shaft in its roof. Taking the torch, or covering the shaft, darkens most
+// of the hall, then lights it back from what is left; every other operation
+// puts it back. Relighting the whole grid is there for comparison.
+static void benchmarkLight(){
+    VoxelGrid voxels = VoxelGrid(glm::ivec3(-MAP_SIZE / 2, -48, -MAP_SIZE / 2), glm::ivec3(MAP_SIZE, 64, MAP_SIZE));
+    glm::ivec3 block;
+
+    for (block.y = -48; block.y < 0; block.y++) {
+        for (block.z = -MAP_SIZE / 2; block.z < MAP_SIZE / 2; block.z++) {
+            for (block.x = -MAP_SIZE / 2; block.x < MAP_SIZE / 2; block.x++) {
+                bool hall = block.y >= -40 && block.y < -16 && abs(block.x) < 28 && abs(block.z) < 28;
+                bool shaft = block.x == 0 && block.z == 0 && block.y >= -16;
+
+                if (!hall && !shaft) voxels.setBlock(block, stone);
+            }
+        }
+    }
+
+    LightEngine lights(voxels);
+    glm::ivec3 torch = glm::ivec3(10, -30, 10);
+    glm::ivec3 shaft = glm::ivec3(0, -1, 0);
+    std::vector<glm::ivec3> dirty;
+
+    lights.addSource(torch, MAX_LIGHT);
+    lights.relightAll();
+
+    benchmark("light/relight_all", 5, 1, [&](long){
+        lights.relightAll();
+        voxels.takeDirtyChunks(dirty);
+    });
+
+    benchmark("light/toggle_torch_open_area", 200, 1, [&](long i){
+        if (i % 2 == 0) lights.removeSource(torch);
+        else lights.addSource(torch, MAX_LIGHT);
+
+        lights.propagate();
+        voxels.takeDirtyChunks(dirty);
+    });
+
+    benchmark("light/toggle_sky_shaft", 20, 1, [&](long i){
+        voxels.setBlock(shaft, i % 2 == 0 ? (Block) stone : (Block) air);
+        lights.blockChanged(shaft);
+        lights.propagate();
+        voxels.takeDirtyChunks(dirty);
+    });
+}
+
+// Chunk meshes coming and going in a page of terrain vertices, with sizes
+// of real chunk meshes
+static void benchmarkBuddyAllocator(){
+    std::mt19937 random(MICRO_SEED);
+    std::uniform_int_distribution<uint32_t> sizes(200, 6000);
+    const long count = 1000;
+
+    BuddyAllocator allocator(1 << 18, 256);
+    std::vector<uint32_t> offsets, lengths;
+
+    for (long i = 0; i < count / 2; i++) {
+        uint32_t offset, length = sizes(random);
+
+        if (allocator.allocate(length, offset)) {
+            offsets.push_back(offset);
+            lengths.push_back(length);
+        }
+    }
+
+    benchmark("buddy/replace_mesh", 200, count, [&](long){
+        for (long i = 0; i < count; i++) {
+            size_t victim = random() % offsets.size();
+            uint32_t offset, length = sizes(random);
+
+            // A mesh too big for the page keeps its old size, which always
+            // fits back in the range it just freed
+            allocator.free(offsets[victim]);
+            if (allocator.allocate(length, offset)) lengths[victim] = length;
+            else allocator.allocate(lengths[victim], offset);
+
+            offsets[victim] = offset;
+        }
+    });
+
+    doNotOptimize(allocator.getStats());
+}
+
+// Compressing a chunk holding the surface, and the region file round trip
+// of its payload, in a temporary directory
+static void benchmarkStorage(){
+    VoxelGrid voxels = VoxelGrid(glm::ivec3(-MAP_SIZE / 2, -48, -MAP_SIZE / 2), glm::ivec3(MAP_SIZE, 64, MAP_SIZE));
+    buildVoxels(voxels);
+
+    const Chunk* chunk = voxels.getChunk(getChunkOf(glm::ivec3(4, (int) mapData[36][36].y, 4)));
+    std::vector<uint8_t> payload;
+    std::unique_ptr<Chunk> decoded;
+
+    benchmark("storage/encode_chunk", 200, 1, [&](long){
+        encodeChunk(chunk, payload);
+        doNotOptimize(payload.size());
+    });
+
+    benchmark("storage/decode_chunk", 200, 1, [&](long){
+        decodeChunk(payload.data(), payload.size(), decoded);
+        doNotOptimize(decoded);
+    });
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "MineGLMicrobench";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    {
+        RegionFile region;
+        region.open((directory / "r.0.0.0.mglr").string());
+
+        benchmark("storage/region_write", 200, 1, [&](long i){
+            region.write(glm::ivec3(i % REGION_SIZE, 0, 0), payload);
+        });
+
+        // Decompressed from the mapping, as chunks are loaded
+        benchmark("storage/region_load", 200, 1, [&](long i){
+            size_t length = 0;
+            const uint8_t* view = region.view(glm::ivec3(i % REGION_SIZE, 0, 0), length);
+
+            decodeChunk(view, length, decoded);
+            doNotOptimize(decoded);
+        });
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+// Falling cows spread over the map, as World::spawnHerd() makes them
+static void fillEntities(EntityStore& entities, int count){
+    std::mt19937 random(MICRO_SEED);
+    std::uniform_real_distribution<float> horizontal(-MAP_SIZE / 2.0f, MAP_SIZE / 2.0f);
+    std::uniform_real_distribution<float> height(-25.0f, 0.0f);
+
+    for (int i = 0; i < count; i++){
+        glm::vec3 position = glm::vec3(horizontal(random), height(random), horizontal(random));
+
+        entities.create(cowMesh, position, 0.0f, glm::vec3(0.0f, -5.0f, 0.0f), {1.5f, glm::vec3(0.5f, 1.0f, 0.5f)});
+    }
+}
+
+static void benchmarkEntities(){
+    VoxelGrid voxels = VoxelGrid(glm::ivec3(-MAP_SIZE / 2, -48, -MAP_SIZE / 2), glm::ivec3(MAP_SIZE, 64, MAP_SIZE));
+    buildVoxels(voxels);
+
+    for (int count : {1000, 10000}){
+        EntityStore entities;
+        fillEntities(entities, count);
+
+        std::string suffix = "_" + std::to_string(count);
+
+        // Tiny steps so the positions barely change over the repetitions
+        benchmark(("entities/integrate" + suffix).c_str(), 200, count, [&](long){
+            integrateVelocities(entities, 1.0e-6f);
+            doNotOptimize(entities.positions[0]);
+        });
+
+        benchmark(("entities/move_through_voxels" + suffix).c_str(), 200, count, [&](long){
+            moveEntities(entities, voxels, 1.0e-6f);
+            doNotOptimize(entities.positions[0]);
+        });
+    }
+}
+
+// Cows at the same density whatever their number, about one per 16 m²
+static void fillSpreadEntities(EntityStore& entities, int count){
+    float side = 4.0f * sqrtf((float) count);
+
+    std::mt19937 random(MICRO_SEED);
+    std::uniform_real_distribution<float> horizontal(-side / 2.0f, side / 2.0f);
+    std::uniform_real_distribution<float> height(-25.0f, 0.0f);
+
+    for (int i = 0; i < count; i++){
+        glm::vec3 position = glm::vec3(horizontal(random), height(random), horizontal(random));
+
+        entities.create(cowMesh, position, 0.0f, glm::vec3(0.0f), {1.5f, glm::vec3(0.5f, 1.0f, 0.5f)});
+    }
+}
+
+static void benchmarkBroadphase(){
+    for (int count : {1000, 10000, 100000}){
+        EntityStore entities;
+        fillSpreadEntities(entities, count);
+
+        SpatialHash broadphase = SpatialHash(3.0f);
+        std::vector<CandidatePair> pairs;
+
+        std::string suffix = "_" + std::to_string(count);
+        long iterations = 200000 / count;
+
+        benchmark(("broadphase/build" + suffix).c_str(), iterations, count, [&](long){
+            broadphase.build(entities);
+            doNotOptimize(broadphase);
+        });
+
+        benchmark(("broadphase/find_pairs" + suffix).c_str(), iterations, count, [&](long){
+            pairs.clear();
+            broadphase.findPairs(pairs);
+            doNotOptimize(pairs.size());
+        });
+
+        // Build, pairs and narrowphase together, as World::tick() runs them
+        benchmark(("broadphase/separate" + suffix).c_str(), iterations, count, [&](long){
+            broadphase.build(entities);
+            pairs.clear();
+            broadphase.findPairs(pairs);
+            separateEntities(entities, pairs);
+            doNotOptimize(entities.positions[0]);
+        });
+
+        std::vector<uint32_t> candidates;
+
+        benchmark(("broadphase/camera_collision" + suffix).c_str(), 20000, 1, [&](long i){
+            glm::vec4 position = glm::vec4(entities.positions[i % count] + glm::vec3(2.0f), 1.0f);
+            collideCameraWithEntities(position, position, entities, broadphase, candidates);
+            doNotOptimize(position);
+        });
+    }
+
+    // The all pairs test the broadphase replaces, for reference
+    EntityStore entities;
+    fillSpreadEntities(entities, 1000);
+
+    benchmark("broadphase/brute_force_pairs_1000", 100, 1000, [&](long){
+        size_t overlapping = 0;
+
+        for (size_t i = 0; i < entities.size(); i++){
+            for (size_t j = i + 1; j < entities.size(); j++){
+                glm::vec3 offset = entities.positions[j] - entities.positions[i];
+                float reach = entities.colliders[i].radius + entities.colliders[j].radius;
+
+                if (glm::dot(offset, offset) < reach * reach) overlapping++;
+            }
+        }
+
+        doNotOptimize(overlapping);
+    });
+}
+
+int main(int argc, char** argv){
+    if (argc > 1) filter = argv[1];
+    const char* outputFilename = argc > 2 ? argv[2] : NULL;
+
+    // Fills the global map used by the collisions
+    Profiler profiler;
+    World world = World(MICRO_SEED, profiler);
+
+    benchmarkPerlinNoise();
+    benchmarkObjModel();
+    benchmarkMatrices();
+    benchmarkBezier();
+    benchmarkCollisions();
+    benchmarkRaycasts();
+    benchmarkTerrain();
+    benchmarkLight();
+    benchmarkBuddyAllocator();
+    benchmarkStorage();
+    benchmarkEntities();
+    benchmarkBroadphase();
+
+    FILE* output = stdout;
+
+    if (outputFilename != NULL){
+        output = fopen(outputFilename, "w");
+
+        if (output == NULL){
+            fprintf(stderr, "ERROR: Cannot open file \"%s\".\n", outputFilename);
+            return EXIT_FAILURE;
+        }
+    }
+
+    fprintf(output, "{\"repetitions\":%d,\"benchmarks\":[\n", REPETITIONS);
+
+    for (size_t i = 0; i < results.size(); i++){
+        const BenchmarkResult& result = results[i];
+
+        fprintf(output, "{\"name\":\"%s\",\"operations\":%ld,\"ns_per_op\":{\"min\":%.3f,\"median\":%.3f,\"mean\":%.3f}}%s\n",
+                result.name.c_str(), result.operations, result.minimum, result.median, result.mean,
+                i + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(output, "]}\n");
+
+    if (output != stdout) fclose(output);
+
+    return 0;
+}
@@ -1,6 +1,8 @@
 #ifndef BEZIER_H
 #define BEZIER_H
 
+#include <vector>
+
 #include <glm/mat4x4.hpp>
 
 class BezierCurve {
@@ -8,4 +10,36 @@ class BezierCurve {
         glm::vec4 calculate(glm::vec4 p0, glm::vec4 p1, glm::vec4 c0, glm::vec4 c1, float delta);
 };
 
-#endif
\ No newline at end of file
+// Many curves of the same shape as BezierCurve::calculate(), evaluated
+// together. Every curve is stored as the coefficients of its polynomial
+// (a + b t + c t² + d t³), one array per coefficient and axis, so evaluating
+// is a Horner loop over dense arrays the compiler can vectorize. Points are
+// written as separate x, y and z arrays for the same reason.
+//
+// Each curve also gets an arc length table, mapping a fraction of its length
+// to the parameter t, so entities can move along it at constant speed.
+class BezierBatch {
+    private:
+        static const int ARC_LENGTH_SAMPLES = 32;
+
+        std::vector<float> ax, ay, az;
+        std::vector<float> bx, by, bz;
+        std::vector<float> cx, cy, cz;
+        std::vector<float> dx, dy, dz;
+
+        std::vector<float> lengths;
+        std::vector<float> arcLengthTable;
+
+        glm::vec3 evaluateOne(size_t curve, float t) const;
+        void buildArcLengthTable(size_t curve);
+
+    public:
+        size_t add(glm::vec4 p0, glm::vec4 p1, glm::vec4 c0, glm::vec4 c1);
+        size_t size() const;
+        float getLength(size_t curve) const;
+
+        void evaluate(const float* parameters, float* x, float* y, float* z) const;
+        void getParametersAtDistance(const float* fractions, float* parameters) const;
+};
+
+#endif
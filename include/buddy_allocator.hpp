@@ -0,0 +1,56 @@
+#ifndef BUDDY_ALLOCATOR_H
+#define BUDDY_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// Units handed out and left free by a BuddyAllocator
+struct BuddyStats {
+    size_t capacity = 0;
+    size_t requested = 0;
+    size_t allocated = 0;
+    size_t largestFree = 0;
+    size_t allocations = 0;
+
+    size_t getFree() const;
+    double getFragmentation() const;
+};
+
+// Buddy allocator of ranges of some unit inside a space of "capacity"
+// units, without touching the space itself, so it can manage GPU buffers.
+// Blocks are powers of two times "minimumBlock" units; a request gets the
+// smallest block that fits, split from a bigger one when needed, and freed
+// blocks merge back with their buddy as soon as it is free too. The lowest
+// free block is always taken first, so allocations pack towards the start.
+//
+// Both "capacity" and "minimumBlock" must be powers of two.
+class BuddyAllocator {
+    private:
+        uint32_t minimumBlock;
+        int orders;
+
+        // Free blocks of minimumBlock << order units, by offset
+        std::vector<std::set<uint32_t>> freeBlocks;
+
+        struct Allocation {
+            int order;
+            uint32_t size;
+        };
+
+        std::unordered_map<uint32_t, Allocation> allocations;
+        BuddyStats stats;
+
+        int orderFor(uint32_t size) const;
+
+    public:
+        BuddyAllocator(uint32_t capacity, uint32_t minimumBlock);
+
+        bool allocate(uint32_t size, uint32_t& offset);
+        void free(uint32_t offset);
+        const BuddyStats& getStats();
+};
+
+#endif
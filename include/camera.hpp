@@ -2,8 +2,13 @@
 #define CAMERA_H
 
 #include <string>
+#include <vector>
 #include <glm/mat4x4.hpp>
 
+#include "entities.hpp"
+#include "spatial_hash.hpp"
+#include "voxel_grid.hpp"
+
 enum Direction { up, down, left, right, none};
 
 class Camera {
@@ -29,12 +34,19 @@ class Camera {
         glm::vec4 positionFree;
         glm::vec4 positionLook;
 
+        // Where the free camera was before the last move()
+        glm::vec4 previousFree;
+
+        // Entities near the camera, kept between collisions
+        std::vector<uint32_t> entityCandidates;
+
         glm::vec4 viewFree;
         glm::vec4 viewLook;
 
     public:
         Camera(float speed, float distance, glm::vec4 positionFree, glm::vec4 positionLook, glm::vec4 viewFree, glm::vec4 viewLook);
-        void move();
+        void move(double deltaTime);
+        void collide(const VoxelGrid& voxels, const EntityStore& entities, const SpatialHash& broadphase);
         float returnX();
         float returnY();
         float returnZ();
@@ -42,6 +54,10 @@ class Camera {
         glm::mat4 getViewFree();
         glm::mat4 getViewLook();
         glm::mat4 getView();
+        glm::vec4 getPosition();
+        glm::vec4 getDirection();
+        bool getIsFree();
+        void setFreePose(glm::vec4 position, float phi, float tetha);
         void changeMode();
         void setUpdatingPosition(Direction direction);
         void updateDistance(float dy);
@@ -0,0 +1,70 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Chunks are cubes of CHUNK_SIZE blocks on every side
+#define CHUNK_SIZE 16
+#define CHUNK_VOLUME (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+
+typedef uint16_t Block;
+
+// Block ids; "air" is the only one that is not solid
+enum BlockType : Block { air, grass, dirt, stone, BLOCK_TYPES };
+
+// Biggest serialized chunk: 16 bit indices into a palette of every block
+#define CHUNK_MAX_SERIALIZED_SIZE (3 + CHUNK_VOLUME * sizeof(Block) + CHUNK_VOLUME * 2)
+
+// Blocks of one chunk, addressed by coordinates local to it, in [0, CHUNK_SIZE).
+//
+// Chunks only hold a few kinds of blocks, so every block is stored as an
+// index into a palette of the kinds used, with as few bits as the palette
+// needs (0, 1, 2, 4, 8 or 16, so no index straddles two words). A chunk of
+// a single kind of block, such as deep ground, stores no indices at all.
+// The palette only grows, reusing the kinds no block uses anymore, until
+// the chunk becomes uniform again.
+class Chunk {
+    private:
+        std::vector<Block> palette = {air};
+        std::vector<uint16_t> counts = {CHUNK_VOLUME};
+        std::vector<uint64_t> words;
+        int bits = 0;
+        int wordShift = 0;
+        int solidCount = 0;
+
+        int getIndex(int i) const;
+        void setIndex(int i, int index);
+        int addToPalette(Block block);
+        void repack(int bits);
+
+    public:
+        static int indexOf(glm::ivec3 local);
+
+        Block get(glm::ivec3 local) const;
+        void set(glm::ivec3 local, Block block);
+        void unpack(Block* blocks, int firstLayer = 0, int lastLayer = CHUNK_SIZE - 1) const;
+        bool isEmpty() const;
+        size_t getMemoryUsage() const;
+
+        // The bits per index, the palette size and the palette as little
+        // endian 16 bit integers, then the words of indices as little endian
+        // 64 bit integers
+        void serialize(std::vector<uint8_t>& data) const;
+        bool deserialize(const uint8_t* data, size_t size);
+};
+
+// Division rounding towards negative infinity, for coordinates
+int floorDivide(int value, int divisor);
+
+// Chunk holding a block, and the coordinates of the block inside of it
+glm::ivec3 getChunkOf(glm::ivec3 block);
+glm::ivec3 getLocalOf(glm::ivec3 block);
+
+// Unique key of a chunk, for hash maps: 21 bits per coordinate
+uint64_t getChunkKey(glm::ivec3 chunk);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef CHUNK_MESHER_H
+#define CHUNK_MESHER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+#include "light_engine.hpp"
+#include "voxel_grid.hpp"
+
+// The blocks of a chunk and a border of MESH_MARGIN blocks around it are
+// meshed together
+#define PADDED_CHUNK_SIZE (CHUNK_SIZE + 2 * MESH_MARGIN)
+#define PADDED_CHUNK_VOLUME (PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE)
+
+// Textures of the terrain, in the order of the layers of the texture array
+// the terrain is drawn with. Every vertex names the layer of its face, so a
+// chunk is drawn in one piece whatever its textures.
+enum TerrainTexture { grassTopTexture, grassSideTexture, dirtTexture, stoneTexture, TERRAIN_TEXTURES };
+
+// Same attributes as the cube the terrain used to be drawn with: position
+// (location 0), normal (location 1) and texture coordinates (location 2),
+// plus the baked light of the vertex (location 7), the color the texture is
+// multiplied with, and its TerrainTexture (location 8).
+struct TerrainVertex {
+    float position[3];
+    int8_t normal[3];
+    uint8_t layer;
+    float textureCoords[2];
+    uint8_t light[4];
+};
+
+// Triangles of the visible faces of one chunk, in world coordinates.
+// "edited" marks the last mesh of a batch of edits, made from "editTime"
+// on; the other meshes of the batch and those from generation leave it
+// unset, so every batch is timed once.
+struct ChunkMesh {
+    glm::ivec3 chunk;
+    std::vector<TerrainVertex> vertices;
+    std::vector<uint32_t> indices;
+    bool edited = false;
+    std::chrono::steady_clock::time_point editTime;
+};
+
+// Builds chunk meshes with only the faces between a solid block and air, the
+// ones at the borders included. The scratch memory is kept between meshes.
+//
+// Lighting is baked into the vertices:
+// - the light of the LightEngine, the brightest of sky and block light;
+// - ambient occlusion: every vertex is darkened by the solid blocks around
+//   it in front of the face, and the light of the air blocks there is
+//   averaged, so light fades smoothly across faces;
+// - the diffuse and ambient terms the terrain was shaded with per fragment,
+//   which only depend on the normal.
+// Quads are split along their less occluded diagonal, so occlusion is
+// interpolated the same way whatever the orientation of the quad.
+class ChunkMesher {
+    private:
+        Block blocks[PADDED_CHUNK_VOLUME];
+        uint8_t light[PADDED_CHUNK_VOLUME];
+        Block unpacked[CHUNK_VOLUME];
+
+        void copyBlocks(const VoxelGrid& voxels, const LightEngine& lights, glm::ivec3 chunk);
+        float bakeVertex(int index, glm::ivec3 normal, glm::vec3 corner, int& occlusion);
+
+    public:
+        void mesh(const VoxelGrid& voxels, const LightEngine& lights, glm::ivec3 chunk, ChunkMesh& mesh);
+};
+
+// Meshes "chunks" on every hardware thread, one mesher per thread; chunk i
+// goes to meshes[i]
+void meshChunks(const VoxelGrid& voxels, const LightEngine& lights, const std::vector<glm::ivec3>& chunks,
+                std::vector<ChunkMesher>& meshers, std::vector<ChunkMesh>& meshes);
+
+// Meshes made by the simulation, waiting for the renderer to upload them
+class ChunkMeshQueue {
+    private:
+        std::mutex mutex;
+        std::vector<ChunkMesh> meshes;
+
+    public:
+        void push(ChunkMesh&& mesh);
+        void drain(std::vector<ChunkMesh>& drained);
+};
+
+#endif
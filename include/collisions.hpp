@@ -1,11 +1,16 @@
 #ifndef COLLISIONS_HPP
 #define COLLISIONS_HPP
 
+#include <cstdint>
+#include <vector>
+
 #include <glm/glm.hpp>
+#include "entities.hpp"
 #include "globals.hpp"
+#include "spatial_hash.hpp"
 
-void collideCameraWithMap(glm::vec4& position, glm::vec4 mapData[64][64]);
-void collideCameraWithCow(glm::vec4 &cameraPosition, glm::vec3 &cowPosition);
-bool collideCowWithMap(glm::vec3 cowPosition, glm::vec4 mapData[64][64]);
+void collideCameraWithEntities(glm::vec4 &cameraPosition, glm::vec4 previousPosition, const EntityStore &entities,
+                               const SpatialHash &broadphase, std::vector<uint32_t> &candidates);
+void separateEntities(EntityStore &entities, const std::vector<CandidatePair> &pairs);
 
 #endif 
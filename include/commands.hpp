@@ -0,0 +1,33 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <mutex>
+#include <vector>
+
+#include "camera.hpp"
+
+enum CommandType { moveCamera, rotateCamera, zoomCamera, changeCameraMode, rotateCow, breakBlock, placeBlock, toggleTorch };
+
+// One input event for the simulation. "direction" is used by moveCamera,
+// "dx" and "dy" by the other commands.
+struct Command {
+    CommandType type;
+    Direction direction = none;
+    float dx = 0.0f;
+    float dy = 0.0f;
+};
+
+// Input events pushed by the window callbacks and applied by the simulation
+// at the start of its next tick, so the camera and the cow are only ever
+// written by the simulation thread.
+class CommandQueue {
+    private:
+        std::mutex mutex;
+        std::vector<Command> commands;
+
+    public:
+        void push(const Command& command);
+        void drain(std::vector<Command>& drained);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+typedef uint32_t EntityId;
+
+// Meshes the renderer knows how to draw
+enum Mesh { cowMesh, leafMesh };
+
+// Sphere of "radius" around the position, used against the camera and the
+// other entities, and box of "halfExtents" around it, used against the
+// blocks of the map. A zero radius or zero extents turn either one off.
+struct Collider {
+    float radius;
+    glm::vec3 halfExtents;
+};
+
+class VoxelGrid;
+
+// Structure of arrays storage for the dynamic objects of the world. Every
+// component lives in its own dense array and the same index refers to the
+// same entity in all of them, so systems loop over exactly the data they
+// need. Destroying an entity moves the last one into its slot, which keeps
+// the arrays dense but changes indices: use the EntityId to refer to an
+// entity across frames. Ids are never reused.
+class EntityStore {
+    private:
+        static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+        std::vector<EntityId> ids;
+        std::vector<uint32_t> indices;
+
+    public:
+        // Components, indexed by dense index. Systems may write the values,
+        // but only create() and destroy() may change the sizes.
+        std::vector<glm::vec3> positions;
+        std::vector<float> rotations;
+        std::vector<glm::vec3> velocities;
+        std::vector<Mesh> meshes;
+        std::vector<Collider> colliders;
+
+        EntityId create(Mesh mesh, glm::vec3 position, float rotation, glm::vec3 velocity, Collider collider);
+        void destroy(EntityId id);
+        bool isAlive(EntityId id) const;
+        size_t indexOf(EntityId id) const;
+        size_t size() const;
+        const std::vector<EntityId>& getIds() const;
+        void reserve(size_t count);
+};
+
+// Systems, each a single pass over the component arrays
+void integrateVelocities(EntityStore& entities, float deltaTime);
+void applyGravity(EntityStore& entities, float gravity, float maxFallSpeed, float deltaTime);
+void moveEntities(EntityStore& entities, const VoxelGrid& voxels, float deltaTime);
+void destroyEntitiesBelow(EntityStore& entities, float height);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef GENERATION_CACHE_H
+#define GENERATION_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+#include "region_file.hpp"
+
+// Bytes of chunks kept in memory by default
+#define GENERATION_CACHE_CAPACITY (64 * 1024 * 1024)
+
+struct GenerationCacheStats {
+    long hits = 0;
+    long diskHits = 0;
+    long misses = 0;
+    long evictions = 0;
+    long spills = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+
+    // Share of the lookups found in memory or on disk
+    double getHitRate() const;
+};
+
+// Chunks as TerrainGenerator made them, before any edit, keyed by seed,
+// TERRAIN_GENERATOR_VERSION and chunk coordinates, so a chunk generated
+// once is copied instead of generated again. Chunks of only air are cached
+// too.
+//
+// Memory is bounded to "capacity" bytes: the least recently used chunks are
+// evicted first. With a spill directory, evicted chunks, and the ones left
+// when the cache is destroyed, are written to region files there, one set
+// per seed and version, and read back on a miss; otherwise they are lost.
+//
+// Not thread safe: meant for the thread that generates worlds.
+class GenerationCache {
+    private:
+        struct Key {
+            unsigned int seed;
+            int version;
+            glm::ivec3 chunk;
+
+            bool operator==(const Key& other) const;
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry {
+            Key key;
+            std::unique_ptr<Chunk> blocks;
+            size_t bytes;
+            bool spilled;
+        };
+
+        size_t capacity;
+        std::string spillDirectory;
+
+        // Most recently used first
+        std::list<Entry> entries;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        std::unordered_map<std::string, std::unique_ptr<RegionFile>> regions;
+        GenerationCacheStats stats;
+
+        RegionFile* getRegion(const Key& key, bool create);
+        bool readSpilled(const Key& key, std::unique_ptr<Chunk>& blocks);
+        void spill(Entry& entry);
+        void add(const Key& key, std::unique_ptr<Chunk> blocks, bool spilled);
+        void evict();
+
+    public:
+        GenerationCache(size_t capacity, const char* spillDirectory = NULL);
+        GenerationCache(const GenerationCache&) = delete;
+        GenerationCache& operator=(const GenerationCache&) = delete;
+        ~GenerationCache();
+
+        bool find(unsigned int seed, glm::ivec3 chunk, std::unique_ptr<Chunk>& blocks);
+        void insert(unsigned int seed, glm::ivec3 chunk, const Chunk* blocks);
+        void flush();
+        const GenerationCacheStats& getStats();
+};
+
+#endif
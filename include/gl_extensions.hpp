@@ -0,0 +1,46 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+// The glad loader in include/glad only covers the OpenGL 3.3 core API. Entry
+// points from newer versions (or their ARB extensions) are declared and
+// loaded here, in the same way glad does it, and are only valid when the
+// matching GLEXT_* flag is set after loadGlExtensions().
+
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+
+extern int GLEXT_ARB_get_program_binary;
+extern int GLEXT_ARB_buffer_storage;
+extern int GLEXT_ARB_multi_draw_indirect;
+
+extern PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary;
+#define glGetProgramBinary glext_glGetProgramBinary
+extern PFNGLPROGRAMBINARYPROC glext_glProgramBinary;
+#define glProgramBinary glext_glProgramBinary
+extern PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri;
+#define glProgramParameteri glext_glProgramParameteri
+extern PFNGLBUFFERSTORAGEPROC glext_glBufferStorage;
+#define glBufferStorage glext_glBufferStorage
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glext_glMultiDrawElementsIndirect
+
+// Must be called after gladLoadGLLoader(), with the same loader.
+void loadGlExtensions(GLADloadproc load);
+
+#endif
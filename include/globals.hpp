@@ -9,6 +9,7 @@
 #include <glm/glm.hpp>  
                        
 #include "camera.hpp"
+#include "commands.hpp"
 
 #define MAP_SIZE 64
 // Definimos uma estrutura que armazenará dados necessários para renderizar
@@ -57,12 +58,11 @@ extern double g_LastCursorPosX, g_LastCursorPosY;
 
 extern bool isFreeCamera;
 
-extern double deltaTime;
-
 extern Camera camera;
 
+// Input from the window callbacks, applied by World::tick()
+extern CommandQueue inputCommands;
+
 extern glm::vec4 mapData[MAP_SIZE][MAP_SIZE];
-extern glm::vec3 cowPosition;
-extern glm::vec3 cowRotate;
 
 #endif
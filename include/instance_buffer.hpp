@@ -0,0 +1,25 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+
+#include "stream_buffer.hpp"
+
+// Per-instance model matrices for instanced draws, streamed through a
+// StreamBuffer: every frame writes its own section, so uploads never stall
+// on draws still in flight.
+class InstanceBuffer {
+    private:
+        StreamBuffer stream;
+
+    public:
+        InstanceBuffer(size_t capacity);
+
+        size_t upload(const glm::mat4* models, size_t count, GLintptr& offset);
+        void bindAttributes(GLuint location, GLintptr offset);
+        void endFrame();
+        bool isPersistent();
+};
+
+#endif
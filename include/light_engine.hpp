@@ -0,0 +1,84 @@
+#ifndef LIGHT_ENGINE_H
+#define LIGHT_ENGINE_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+#include "voxel_grid.hpp"
+
+// Light of the open sky and of the brightest sources. Light loses one level
+// per block it spreads, except sky light going straight down.
+#define MAX_LIGHT 15
+
+// Sky light comes down from the top of the grid, block light from sources
+// such as torches
+enum LightChannel { skyLight, blockLight, LIGHT_CHANNELS };
+
+// Blocks whose light the last propagate() darkened and lit
+struct LightStats {
+    long removed = 0;
+    long added = 0;
+};
+
+// Light of every block of a VoxelGrid, kept up to date incrementally: after
+// a change, only the blocks whose light depends on it are visited, across
+// chunk borders, however far that is.
+//
+// Changes are queued, then spread by propagate() breadth first, one channel
+// at a time. Darkening goes first: from every block that lost light, the
+// blocks lit through it are set to 0, and those lit from elsewhere are
+// queued to light the darkened blocks back. Then lighting spreads from every
+// block queued until no block gets brighter.
+//
+// Light is stored per chunk of the grid, the sky level in the high nibble of
+// every byte and the block level in the low one. Every block the light
+// changes in marks the chunks it shows in as dirty. Outside of the grid,
+// blocks read as open sky, but only the sky above the grid shines into it.
+class LightEngine {
+    private:
+        struct LightNode {
+            glm::ivec3 block;
+            int level;
+        };
+
+        VoxelGrid& voxels;
+        glm::ivec3 origin;
+        glm::ivec3 size;
+        glm::ivec3 chunkOrigin;
+        glm::ivec3 chunkCounts;
+
+        std::vector<std::unique_ptr<uint8_t[]>> chunks;
+        std::unordered_map<uint64_t, LightNode> sources;
+        std::vector<LightNode> addQueues[LIGHT_CHANNELS];
+        std::vector<LightNode> removeQueues[LIGHT_CHANNELS];
+        LightStats stats;
+
+        uint8_t* getCell(glm::ivec3 block) const;
+        int getEmission(LightChannel channel, glm::ivec3 block) const;
+        void setLight(LightChannel channel, glm::ivec3 block, int level);
+        void spreadRemovals(LightChannel channel);
+        void spreadAdditions(LightChannel channel);
+
+    public:
+        LightEngine(VoxelGrid& voxels);
+        LightEngine(const LightEngine&) = delete;
+        LightEngine& operator=(const LightEngine&) = delete;
+
+        int getLight(LightChannel channel, glm::ivec3 block) const;
+        const uint8_t* getChunkLight(glm::ivec3 chunk) const;
+        void relightAll();
+        void blockChanged(glm::ivec3 block);
+        void chunkReplaced(glm::ivec3 chunk);
+        void addSource(glm::ivec3 block, int level);
+        void removeSource(glm::ivec3 block);
+        bool isSource(glm::ivec3 block) const;
+        void propagate();
+        const LightStats& getStats() const;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef OBJ_LOADER_H
 #define OBJ_LOADER_H
 
+#include <glm/mat4x4.hpp>
+
+#include "instance_buffer.hpp"
 #include "tiny_obj_loader/tiny_obj_loader.h"
 
 class ObjModel {
@@ -14,6 +17,7 @@ class ObjModel {
         void ComputeNormals();
         void BuildTrianglesAndAddToVirtualScene();
         void DrawVirtualObject(const char* object_name);
+        size_t DrawVirtualObjectInstanced(const char* object_name, InstanceBuffer& instances, const glm::mat4* models, size_t count);
 };
 
 #endif
\ No newline at end of file
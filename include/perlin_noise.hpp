@@ -9,13 +9,14 @@ class PerlinNoise {
     private:
         int row;
         int col;
+        unsigned int randomSeed;
         vector<vector<float>> seed;
 
         void generateSeed();
         vector<vector<float>> normalize(vector<vector<float>> grid);
 
     public:
-        PerlinNoise(int row, int col);
+        PerlinNoise(int row, int col, unsigned int randomSeed);
         vector<vector<float>> generateNoise(int octaves);
 };
 
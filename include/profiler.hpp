@@ -0,0 +1,101 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Rolling window of samples (in milliseconds) used to compute percentiles
+class SampleWindow {
+    private:
+        std::vector<double> samples;
+        size_t next = 0;
+        size_t count = 0;
+
+    public:
+        SampleWindow(size_t capacity);
+        void add(double sample);
+        double percentile(double p) const;
+        size_t size() const;
+};
+
+// Per-frame profiler with named phases. Every phase records CPU time with
+// std::chrono::steady_clock and, optionally, GPU time with GL_TIME_ELAPSED
+// queries. Queries are double buffered: the ones issued on frame N are read
+// back on frame N + 2 and skipped if still unavailable, so the CPU never
+// waits on the GPU. Only one GPU phase may be open at a time, and GPU phases
+// need a current OpenGL context when they are added.
+class Profiler {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+    private:
+        static const int QUERY_BUFFERS = 2;
+        static const size_t WINDOW_SIZE = 512;
+        static const size_t MAX_TRACE_EVENTS = 1000000;
+
+        struct Phase {
+            std::string name;
+            bool gpu;
+            Clock::time_point start;
+            GLuint queries[QUERY_BUFFERS];
+            bool pending[QUERY_BUFFERS];
+            SampleWindow cpuTimes = SampleWindow(WINDOW_SIZE);
+            SampleWindow gpuTimes = SampleWindow(WINDOW_SIZE);
+        };
+
+        struct TraceEvent {
+            int phase;
+            bool gpu;
+            double timestamp;
+            double duration;
+        };
+
+        std::string frameName;
+        std::vector<Phase> phases;
+        SampleWindow frames = SampleWindow(WINDOW_SIZE);
+
+        long frame = 0;
+        Clock::time_point origin;
+        Clock::time_point frameStart;
+        Clock::time_point queryFrameStarts[QUERY_BUFFERS];
+
+        std::string traceFilename;
+        std::vector<TraceEvent> trace;
+
+        double toMicroseconds(Clock::time_point time);
+        void collectQueries(int buffer);
+
+    public:
+        Profiler(const char* frameName = "frame");
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        int addPhase(const char* name, bool gpu);
+        void enableTrace(const char* filename);
+
+        void beginFrame();
+        void endFrame();
+        void begin(int phase);
+        void end(int phase);
+
+        void report();
+        void reportJson(FILE* file);
+        bool writeTrace();
+};
+
+// Times the enclosing scope as one of the profiler phases
+class ScopedTimer {
+    private:
+        Profiler& profiler;
+        int phase;
+
+    public:
+        ScopedTimer(Profiler& profiler, int phase);
+        ~ScopedTimer();
+};
+
+#endif
@@ -1,15 +1,21 @@
 #ifndef PROGRAM_H
 #define PROGRAM_H
 
+#include <vector>
+
 #include <glad/glad.h>
 
 class Program {
     private:
         GLuint id = 0;
 
+        bool checkLinkStatus(bool reportErrors);
+
     public:
         GLuint getId();
-        void createGpuProgram(GLuint vertexShader, GLuint fragmentShader);
+        bool createGpuProgram(GLuint vertexShader, GLuint fragmentShader);
+        bool createGpuProgramFromBinary(GLenum binaryFormat, const std::vector<char>& binary);
+        bool getBinary(GLenum& binaryFormat, std::vector<char>& binary);
 };
 
-#endif
\ No newline at end of file
+#endif
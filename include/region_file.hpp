@@ -0,0 +1,76 @@
+#ifndef REGION_FILE_H
+#define REGION_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Regions are cubes of REGION_SIZE chunks on every side, one file each
+#define REGION_SIZE 16
+#define REGION_VOLUME (REGION_SIZE * REGION_SIZE * REGION_SIZE)
+
+// Payloads are stored in whole sectors, so the sectors of replaced payloads
+// can be reused by later ones
+#define REGION_SECTOR_SIZE 4096
+
+// One file holding the payloads of the chunks of a region. The file starts
+// with a header and a table with the first sector and the length of every
+// chunk payload, zero for chunks never written; the payloads follow, each
+// one in its own run of sectors.
+//
+// Payloads are never overwritten in place: a new payload goes to the first
+// run of free sectors big enough for it, or to the end of the file, and
+// only then does its table entry point to it, after which the sectors of
+// the previous payload become free. An interrupted write, such as the
+// process being killed, thus leaves the previous version of the chunk;
+// surviving a power loss as well would take an fsync() between the two.
+// All numbers are little endian.
+//
+// The file is mapped in memory, so payloads are read in place through
+// view(), with no copy; the mapping grows with the file. Pages are only read
+// from disk when touched, or ahead of time after advise().
+class RegionFile {
+    private:
+        struct Entry {
+            uint32_t sector;
+            uint32_t length;
+        };
+
+        std::string filename;
+        int descriptor = -1;
+        Entry table[REGION_VOLUME];
+        uint32_t sectorCount = 0;
+
+        // Sectors holding a payload a table entry points to
+        std::vector<bool> usedSectors;
+
+        const uint8_t* mapping = NULL;
+        size_t mappedSize = 0;
+
+        static int indexOf(glm::ivec3 local);
+        bool map();
+        void markSectors(const Entry& entry, bool used);
+        uint32_t findFreeSectors(uint32_t sectors);
+
+    public:
+        RegionFile() = default;
+        RegionFile(const RegionFile&) = delete;
+        RegionFile& operator=(const RegionFile&) = delete;
+        ~RegionFile();
+
+        bool open(const std::string& filename);
+        bool isOpen();
+        bool has(glm::ivec3 local);
+        const uint8_t* view(glm::ivec3 local, size_t& length);
+        void advise(glm::ivec3 local);
+        bool write(glm::ivec3 local, const std::vector<uint8_t>& payload);
+
+        // Region holding a chunk, and the coordinates of the chunk inside of it
+        static glm::ivec3 getRegionOf(glm::ivec3 chunk);
+        static glm::ivec3 getLocalOf(glm::ivec3 chunk);
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+
+#include <chrono>
+#include <vector>
+
+#include "chunk_mesher.hpp"
+#include "instance_buffer.hpp"
+#include "obj_loader.hpp"
+#include "profiler.hpp"
+#include "shaders_provider.hpp"
+#include "terrain_meshes.hpp"
+#include "texture.hpp"
+#include "world.hpp"
+
+// Uniform locations of the GPU program, queried again whenever the shaders
+// are hot reloaded.
+struct ProgramUniforms {
+    GLint model;
+    GLint view;
+    GLint projection;
+    GLint objectId;
+    GLint sampler;
+    GLint terrainSampler;
+    GLint gouraud;
+    GLint instanced;
+    GLint baked;
+};
+
+struct RenderStats {
+    long drawCalls = 0;
+    long triangles = 0;
+    long visibleChunks = 0;
+};
+
+// Owns every OpenGL resource of the scene and draws a WorldState with it.
+// Needs a current OpenGL context, but no window: the headless benchmark
+// renders into an offscreen framebuffer with it.
+class Renderer {
+    private:
+        ShadersProvider shaderProvider;
+        GLuint programId;
+        ProgramUniforms uniforms;
+
+        // Chunk meshes of the terrain, and when the edits they show were made
+        TerrainMeshes terrain;
+        std::vector<ChunkMesh> chunkMeshes;
+        std::vector<std::chrono::steady_clock::time_point> pendingEdits;
+        SampleWindow editLatencies = SampleWindow(512);
+
+        ObjModel cowModel = ObjModel("assets/cow.obj");
+        ObjModel leafModel = ObjModel("assets/leaf.obj");
+
+        // Model matrices of the entities, grouped by mesh for instanced draws
+        InstanceBuffer instances;
+        std::vector<glm::mat4> cowModels;
+        std::vector<glm::mat4> leafModels;
+
+        Texture skyBack = Texture("assets/sky_back.png", GL_TEXTURE_2D);
+        Texture skyDown = Texture("assets/sky_down.png", GL_TEXTURE_2D);
+        Texture skyUp = Texture("assets/sky_up.png", GL_TEXTURE_2D);
+        Texture skyRight = Texture("assets/sky_right.png", GL_TEXTURE_2D);
+        Texture skyLeft = Texture("assets/sky_left.png", GL_TEXTURE_2D);
+        Texture skyFront = Texture("assets/sky_front.png", GL_TEXTURE_2D);
+
+        // Layers indexed by TerrainTexture
+        ArrayTexture terrainTextures = ArrayTexture({
+            "assets/grass_top.jpg",
+            "assets/grass_side.png",
+            "assets/dirt.png",
+            "assets/stone.png",
+        });
+
+        RenderStats stats;
+
+        Profiler& profiler;
+        int worldPhase;
+        int modelsPhase;
+
+        void beginFrame(const glm::mat4& view, const glm::mat4& projection);
+        void drawWorld(const glm::mat4& viewProjection);
+        void drawInstances(ObjModel& model, const char* objectName, int objectId, const std::vector<glm::mat4>& models);
+        void drawModels(const WorldState& state);
+
+    public:
+        Renderer(Profiler& profiler);
+        ShadersProvider& getShadersProvider();
+        bool reloadShaders();
+        void updateTerrain(ChunkMeshQueue& meshes);
+        void render(const glm::mat4& projection, const WorldState& state);
+        RenderStats getStats();
+        size_t getChunkMeshCount();
+        MeshMemoryStats getMeshMemoryStats();
+        const SampleWindow& getEditLatencies();
+};
+
+#endif
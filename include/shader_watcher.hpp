@@ -0,0 +1,33 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <string>
+#include <vector>
+
+// Watches shader source files for modifications using inotify. The watch is
+// placed on the parent directory, so editors that save by writing a new file
+// and renaming it over the old one are also detected. On platforms without
+// inotify the watcher is inert and never reports changes.
+class ShaderWatcher {
+    private:
+        struct WatchedFile {
+            int directoryWatch;
+            std::string name;
+        };
+
+        int fd = -1;
+        std::vector<int> directoryWatches;
+        std::vector<std::string> directories;
+        std::vector<WatchedFile> files;
+
+    public:
+        ShaderWatcher();
+        ~ShaderWatcher();
+        ShaderWatcher(const ShaderWatcher&) = delete;
+        ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+        void watch(const char* filename);
+        bool poll();
+};
+
+#endif
@@ -1,19 +1,33 @@
 #ifndef SHADERS_PROVIDER_H
 #define SHADERS_PROVIDER_H
 
+#include <cstdint>
+#include <string>
+
 #include <glad/glad.h>
 
+#include "program.hpp"
+
 class ShadersProvider {
     private:
         const char* vertexShaderFilename = "./src/shaders/shader_vertex.glsl";
         const char* fragmentShaderFilename = "./src/shaders/shader_fragment.glsl";
-        GLuint vertexShader;
-        GLuint fragmentShader;
+        const char* cacheDirectory = "./cache";
+
+        bool readShaderFile(const char* filename, std::string& source);
+        std::string getCacheFilename();
+        uint64_t getCacheKey(const std::string& vertexSource, const std::string& fragmentSource);
+        GLuint loadProgramFromCache(uint64_t key);
+        void saveProgramToCache(uint64_t key, Program& program);
+        GLuint buildProgram(const std::string& vertexSource, const std::string& fragmentSource, uint64_t key);
 
     public:
         GLuint loadShadersFromFiles();
-        GLuint loadShaderByType(const char* filename, GLenum shaderType);
-        void loadShader(const char* filename, GLuint shaderId);
+        GLuint reloadShadersFromFiles();
+        GLuint loadShaderByType(const char* filename, const std::string& source, GLenum shaderType);
+        bool loadShader(const char* filename, const std::string& source, GLuint shaderId);
+        const char* getVertexShaderFilename();
+        const char* getFragmentShaderFilename();
 };
 
-#endif
\ No newline at end of file
+#endif
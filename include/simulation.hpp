@@ -0,0 +1,50 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "profiler.hpp"
+#include "triple_buffer.hpp"
+#include "world.hpp"
+
+// Immutable result of one tick, handed from the simulation thread to the
+// render thread. Both states are kept so the renderer can interpolate.
+struct FrameSnapshot {
+    WorldState previous;
+    WorldState current;
+    std::chrono::steady_clock::time_point publishTime;
+};
+
+// Runs World::tick() every SIMULATION_STEP seconds on its own thread, so the
+// simulation overlaps with the OpenGL submission of the render thread. Every
+// tick publishes a FrameSnapshot through a triple buffer; the render thread
+// never blocks on the simulation and never reads the World directly.
+//
+// "profiler" is only used from the simulation thread, so it must not be the
+// profiler of the render thread.
+class Simulation {
+    private:
+        World& world;
+        Profiler& profiler;
+
+        TripleBuffer<FrameSnapshot> snapshots;
+
+        std::atomic<bool> running{false};
+        std::thread thread;
+
+        void run();
+
+    public:
+        Simulation(World& world, Profiler& profiler);
+        Simulation(const Simulation&) = delete;
+        Simulation& operator=(const Simulation&) = delete;
+        ~Simulation();
+
+        void start();
+        void stop();
+        WorldState getState();
+};
+
+#endif
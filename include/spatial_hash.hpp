@@ -0,0 +1,46 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "entities.hpp"
+
+typedef std::pair<uint32_t, uint32_t> CandidatePair;
+
+// Collision broadphase: a uniform grid of cells hashed into a table of
+// buckets, rebuilt from scratch every tick with a counting sort, so building
+// is linear in the number of entities and the entries of a bucket are
+// contiguous. Every entity with a collider is stored in the cell of its
+// center. The cell size must be at least the diameter of the biggest
+// collider, so two entities can only touch if they are in the same or
+// neighbouring cells.
+//
+// Every entry also keeps its cell, so entities of unrelated cells sharing a
+// bucket are skipped. Results are dense entity indices, valid until the store
+// changes, and still need a narrowphase test.
+class SpatialHash {
+    private:
+        float cellSize;
+        float maxRadius = 0.0f;
+
+        std::vector<glm::ivec3> entityCells;
+        std::vector<uint32_t> bucketStarts;
+        std::vector<uint32_t> entries;
+        std::vector<glm::ivec3> entryCells;
+
+        glm::ivec3 getCell(glm::vec3 position) const;
+        uint32_t getBucket(glm::ivec3 cell) const;
+
+    public:
+        SpatialHash(float cellSize);
+
+        void build(const EntityStore& entities);
+        void query(glm::vec3 center, float radius, std::vector<uint32_t>& candidates) const;
+        void findPairs(std::vector<CandidatePair>& pairs) const;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// Ring buffer for data the CPU writes every frame and the GPU reads once,
+// such as instance matrices or meshes on their way to their own buffers. It
+// is split in one section per frame in flight; every frame writes its own
+// section, so writes never wait for draws still reading an older one.
+//
+// With ARB_buffer_storage (OpenGL 4.4) the buffer is mapped persistently and
+// coherently once, and a fence per section makes sure the GPU is done
+// reading it before it is written again. On plain OpenGL 3.3 each write maps
+// its range unsynchronized instead, and the buffer is orphaned every time
+// the ring wraps around, so the driver hands out fresh storage while the GPU
+// still reads the old one.
+//
+// Writes are bound to GL_COPY_WRITE_BUFFER, which leaves the bindings of
+// vertex arrays alone.
+class StreamBuffer {
+    private:
+        static const int SECTIONS = 3;
+
+        GLuint bufferId;
+        size_t sectionSize;
+        bool persistent;
+        uint8_t* mapping = NULL;
+
+        int section = 0;
+        size_t used = 0;
+        GLsync fences[SECTIONS] = {};
+
+        void waitForSection(int section);
+
+    public:
+        StreamBuffer(size_t sectionSize);
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+        ~StreamBuffer();
+
+        bool write(const void* data, size_t size, size_t alignment, GLintptr& offset);
+        size_t getRemaining(size_t alignment);
+        void endFrame();
+        GLuint getId();
+        bool isPersistent();
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef TERRAIN_GENERATOR_H
+#define TERRAIN_GENERATOR_H
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+
+// Bumped whenever the same seed starts giving other blocks
+#define TERRAIN_GENERATOR_VERSION 1
+
+// Stages of TerrainGenerator::generate(), in the order they run
+enum GeneratorStage { heightsStage, strataStage, cavesStage, biomesStage, GENERATOR_STAGES };
+
+extern const char* generatorStageNames[GENERATOR_STAGES];
+
+// Time spent generating "chunks" chunks: per stage, summed over every
+// thread, and from start to end
+struct GeneratorTimings {
+    long chunks = 0;
+    double stageMilliseconds[GENERATOR_STAGES] = {};
+    double wallMilliseconds = 0.0;
+};
+
+// Generates the terrain of any chunk from the seed alone, so chunks can be
+// generated in any order and on any thread. Every chunk goes through the
+// stages in order:
+//
+// - heights: the surface height of every column, blended between flat
+//   plains and rocky hills by a low frequency biome noise;
+// - strata: grass on top, a few blocks of dirt, then stone all the way down;
+// - caves: blocks where a 3D noise is high enough are carved out, deep
+//   enough under the surface;
+// - biomes: the surface of hills is bare stone, dithered along the border
+//   so the two biomes blend instead of meeting on a straight line.
+class TerrainGenerator {
+    private:
+        unsigned int seed;
+
+        float getBiome(int x, int z) const;
+        int getHeight(int x, int z, float biome) const;
+
+    public:
+        TerrainGenerator(unsigned int seed);
+
+        int getHeight(int x, int z) const;
+        void generate(glm::ivec3 chunk, Chunk& blocks, double stageMilliseconds[GENERATOR_STAGES]) const;
+};
+
+// Generates "chunks" on every hardware thread; chunk i goes to generated[i],
+// NULL when it is only air. The time spent is added to "timings".
+void generateChunks(const TerrainGenerator& generator, const std::vector<glm::ivec3>& chunks,
+                    std::vector<std::unique_ptr<Chunk>>& generated, GeneratorTimings& timings);
+
+#endif
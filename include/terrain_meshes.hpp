@@ -0,0 +1,164 @@
+#ifndef TERRAIN_MESHES_H
+#define TERRAIN_MESHES_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "buddy_allocator.hpp"
+#include "chunk_mesher.hpp"
+#include "stream_buffer.hpp"
+
+// Bytes of chunk meshes staged per frame; the rest of a bigger burst, such as
+// the whole terrain on the first frame, is uploaded directly
+#define TERRAIN_STAGING_SIZE (4 * 1024 * 1024)
+
+// Vertices and indices of a page of chunk meshes, and the smallest ranges
+// they are handed out in. A page holds the whole terrain of a 4x4x4 chunk
+// world several times over; chunks with bigger meshes get bigger pages.
+#define TERRAIN_PAGE_VERTICES (1 << 18)
+#define TERRAIN_PAGE_INDICES (1 << 19)
+#define TERRAIN_MIN_VERTICES 256
+#define TERRAIN_MIN_INDICES 512
+
+// Draws of visible chunks one frame can submit indirectly, one per chunk;
+// frames with more fall back to client side draw arrays
+#define TERRAIN_MAX_DRAWS 16384
+
+// Frames the ranges of a replaced mesh are kept before they are reused, so
+// they are never written while older frames still draw them
+#define TERRAIN_FRAMES_IN_FLIGHT 3
+
+// Memory of the chunk meshes on the GPU. "used" bytes hold meshes,
+// "allocated" ones include the rounding of the ranges. Fragmentation is the
+// share of the free memory a mesh cannot get in one piece, for the worst of
+// vertices and indices.
+struct MeshMemoryStats {
+    long pages = 0;
+    long defragmentations = 0;
+    size_t usedBytes = 0;
+    size_t allocatedBytes = 0;
+    size_t capacityBytes = 0;
+    double fragmentation = 0.0;
+};
+
+// GPU copies of the chunk meshes, replaced whenever a new mesh of the chunk
+// comes in. Needs a current OpenGL context.
+//
+// Meshes are sub-allocated from pages: a vertex buffer and an index buffer
+// shared by many chunks, with one vertex array for all of them, so drawing
+// a page binds it once. Ranges are handed out by a BuddyAllocator per
+// buffer; indices stay relative to the first vertex of their chunk, which
+// every draw passes as base vertex. When no page has a free range big enough
+// for a mesh but one has enough free memory, its meshes are packed into a
+// new page, copying them on the GPU; otherwise a page is added. Empty pages
+// other than the first are released.
+//
+// Meshes are written to a StreamBuffer, then copied on the GPU to their
+// ranges, so uploads never wait for draws still in flight.
+//
+// Every frame, cull() keeps the chunks inside the view frustum and lists
+// their draws by page. Each page is then one submission, whatever the number
+// of chunks and their textures: glMultiDrawElementsIndirect
+// with the commands of the frame written to a StreamBuffer when
+// ARB_multi_draw_indirect is there, glMultiDrawElementsBaseVertex from
+// arrays in client memory on plain OpenGL 3.3.
+class TerrainMeshes {
+    private:
+        struct MeshPage {
+            GLuint vertexArrayId;
+            GLuint vertexBufferId;
+            GLuint indexBufferId;
+            uint32_t vertexCapacity;
+            uint32_t indexCapacity;
+            BuddyAllocator vertices;
+            BuddyAllocator indices;
+
+            // Nothing was freed since the page was last defragmented
+            bool packed = false;
+
+            MeshPage(uint32_t vertexCapacity, uint32_t indexCapacity);
+            MeshPage(const MeshPage&) = delete;
+            MeshPage& operator=(const MeshPage&) = delete;
+            ~MeshPage();
+        };
+
+        struct GpuChunk {
+            glm::ivec3 chunk;
+            MeshPage* page;
+            uint32_t firstVertex;
+            uint32_t vertexCount;
+            uint32_t firstIndex;
+            uint32_t indexCount;
+        };
+
+        // Ranges of a replaced mesh, freed TERRAIN_FRAMES_IN_FLIGHT frames
+        // after "frame"
+        struct RetiredRange {
+            MeshPage* page;
+            uint32_t firstVertex;
+            uint32_t firstIndex;
+            long frame;
+        };
+
+        // Layout of DrawElementsIndirectCommand
+        struct DrawCommand {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+        };
+
+        // Draws "first" to "first + count" of the frame, all in one page
+        struct DrawBatch {
+            GLuint vertexArrayId;
+            size_t first;
+            size_t count;
+            GLintptr indirectOffset;
+        };
+
+        std::vector<std::unique_ptr<MeshPage>> pages;
+        std::unordered_map<uint64_t, GpuChunk> chunks;
+        std::vector<RetiredRange> retired;
+        StreamBuffer staging;
+
+        // Draws of the frame
+        std::vector<const GpuChunk*> visible;
+        std::vector<DrawCommand> commands;
+        std::vector<GLsizei> counts;
+        std::vector<const void*> offsets;
+        std::vector<GLint> baseVertices;
+        std::vector<DrawBatch> batches;
+        long triangles = 0;
+        StreamBuffer indirectCommands;
+        bool indirect;
+
+        long frame = 0;
+        long defragmentations = 0;
+
+        bool allocate(MeshPage& page, GpuChunk& chunk);
+        void place(GpuChunk& chunk);
+        void retire(const GpuChunk& chunk);
+        void defragment(std::unique_ptr<MeshPage>& page);
+        void releaseEmptyPages();
+        void fill(GLuint bufferId, size_t offset, const void* data, size_t size);
+
+    public:
+        TerrainMeshes();
+        TerrainMeshes(const TerrainMeshes&) = delete;
+        TerrainMeshes& operator=(const TerrainMeshes&) = delete;
+
+        void upload(const ChunkMesh& mesh);
+        long cull(const glm::mat4& viewProjection);
+        long draw(long& triangles);
+        void endFrame();
+        size_t size();
+        MeshMemoryStats getMemoryStats();
+};
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <glad/glad.h>
 #include <string>
+#include <vector>
 
 class Texture {
     private:
@@ -16,4 +17,18 @@ class Texture {
         void bind(GLenum unit);
 };
 
+// Images of several files as the layers of one GL_TEXTURE_2D_ARRAY, so draws
+// using any of them need no texture switch. Images are scaled to the size of
+// the biggest one.
+class ArrayTexture {
+    private:
+        std::vector<std::string> files;
+        GLuint object;
+
+    public:
+        ArrayTexture(std::vector<std::string> files);
+        void load();
+        void bind(GLenum unit);
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Lock free single producer, single consumer triple buffer. The writer fills
+// its back slot and publishes it by swapping it with the middle slot; the
+// reader swaps the middle slot with its front slot only when something new
+// was published. Neither side ever waits, the reader always sees the latest
+// complete value, and values skipped by a slow reader are simply dropped.
+template <typename T>
+class TripleBuffer {
+    private:
+        // Set in "middle" when its slot holds a value the reader has not taken
+        static const int FRESH = 4;
+
+        T slots[3];
+        int back = 0;
+        std::atomic<int> middle{1};
+        int front = 2;
+
+    public:
+        TripleBuffer(const T& initial){
+            for (T& slot : this->slots) slot = initial;
+        }
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        // Writer side: the slot to fill before calling publish()
+        T& getBack(){
+            return this->slots[this->back];
+        }
+
+        void publish(){
+            this->back = this->middle.exchange(this->back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+        }
+
+        // Reader side: the latest published value, valid until the next call
+        const T& read(){
+            if (this->middle.load(std::memory_order_relaxed) & FRESH){
+                this->front = this->middle.exchange(this->front, std::memory_order_acq_rel) & ~FRESH;
+            }
+
+            return this->slots[this->front];
+        }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef VOXEL_GRID_H
+#define VOXEL_GRID_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+
+// Chunk meshes depend on the blocks and light up to this far out of their
+// chunk, so a change shows in every chunk within this distance of it
+#define MESH_MARGIN 1
+
+// Axis aligned box, in world coordinates
+struct Aabb {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Which axes a sweep was stopped on
+struct SweepResult {
+    glm::vec3 displacement;
+    glm::bvec3 hit;
+};
+
+// First solid block along a ray: "normal" points out of the face the ray
+// came in through, and is zero when the ray starts inside the block.
+struct RaycastHit {
+    bool hit;
+    glm::ivec3 block;
+    glm::ivec3 normal;
+    float distance;
+};
+
+// Blocks of the map, stored in chunks of CHUNK_SIZE blocks. Block (x, y, z)
+// is the unit cube centered at those integer world coordinates, the way the
+// terrain is drawn. The grid covers a fixed box, whose corners are multiples
+// of CHUNK_SIZE; everything outside of it is air, and chunks holding only air
+// take no memory.
+//
+// Every change marks the chunks it shows in as dirty: the chunk of the block
+// first, then every chunk within MESH_MARGIN blocks of it.
+class VoxelGrid {
+    private:
+        glm::ivec3 origin;
+        glm::ivec3 size;
+        glm::ivec3 chunkOrigin;
+        glm::ivec3 chunkCounts;
+
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        std::vector<uint8_t> dirty;
+        std::vector<glm::ivec3> dirtyChunks;
+
+        bool contains(glm::ivec3 block) const;
+        bool containsChunk(glm::ivec3 chunk) const;
+        size_t indexOfChunk(glm::ivec3 chunk) const;
+        void markDirty(glm::ivec3 chunk);
+
+    public:
+        VoxelGrid(glm::ivec3 origin, glm::ivec3 size);
+
+        Block getBlock(glm::ivec3 block) const;
+        void setBlock(glm::ivec3 block, Block type);
+        void replaceChunk(glm::ivec3 chunk, std::unique_ptr<Chunk> blocks);
+        bool isSolid(glm::ivec3 block) const;
+        const Chunk* getChunk(glm::ivec3 chunk) const;
+        void listChunks(std::vector<glm::ivec3>& chunks) const;
+        void markDirtyAround(glm::ivec3 min, glm::ivec3 max);
+        void takeDirtyChunks(std::vector<glm::ivec3>& taken);
+        size_t getMemoryUsage() const;
+        glm::ivec3 getOrigin() const;
+        glm::ivec3 getSize() const;
+};
+
+// Moves "box" by "displacement" through the solid blocks of "grid", one axis
+// at a time (y, then x, then z). Every axis only visits the layers of blocks
+// the box crosses along it, so nothing tunnels however long the step, and
+// the result only depends on the inputs. Blocks the box already overlaps are
+// ignored, so a box stuck inside the terrain can still get out.
+SweepResult sweepAabb(const VoxelGrid& grid, const Aabb& box, glm::vec3 displacement);
+
+// Walks the blocks along the ray from "origin" towards "direction" (of any
+// length) one block at a time, as in Amanatides and Woo's "A Fast Voxel
+// Traversal Algorithm", up to "maxDistance". The ray is first clipped to the
+// grid, so the cost is the number of blocks it crosses inside of it.
+RaycastHit raycast(const VoxelGrid& grid, glm::vec3 origin, glm::vec3 direction, float maxDistance);
+
+// raycast() of "count" rays at once, for when many are needed per tick
+void raycastBatch(const VoxelGrid& grid, const glm::vec3* origins, const glm::vec3* directions, size_t count,
+                  float maxDistance, RaycastHit* hits);
+
+// Whether no solid block stands between the two points
+bool hasLineOfSight(const VoxelGrid& grid, glm::vec3 from, glm::vec3 to);
+
+#endif
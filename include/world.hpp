@@ -0,0 +1,157 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+
+#include "bezier.hpp"
+#include "chunk_mesher.hpp"
+#include "commands.hpp"
+#include "entities.hpp"
+#include "generation_cache.hpp"
+#include "light_engine.hpp"
+#include "profiler.hpp"
+#include "spatial_hash.hpp"
+#include "terrain_generator.hpp"
+#include "voxel_grid.hpp"
+#include "world_storage.hpp"
+
+// Fixed simulation rate, independent from the rendering frame rate
+#define SIMULATION_STEP (1.0 / 60.0)
+
+// Broadphase cell size, at least the diameter of the biggest collider
+#define BROADPHASE_CELL_SIZE 3.0f
+
+// Everything the renderer needs from one simulation tick: the camera and a
+// copy of the entity transforms, in the dense order of the EntityStore.
+// States are plain values, so they can be copied to the render thread and
+// interpolated there without touching the World.
+struct WorldState {
+    bool cameraFree = true;
+    glm::vec4 cameraPosition = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    glm::vec4 cameraDirection = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+
+    std::vector<EntityId> entityIds;
+    std::vector<glm::vec3> entityPositions;
+    std::vector<float> entityRotations;
+    std::vector<Mesh> entityMeshes;
+
+    glm::mat4 getView() const;
+    glm::mat4 getEntityModel(size_t index) const;
+};
+
+// Blends two consecutive ticks, "alpha" being how far past "previous" the
+// rendered frame is, in [0, 1].
+WorldState interpolateStates(const WorldState& previous, const WorldState& current, float alpha);
+
+// Simulation state of the scene, independent from any window or OpenGL
+// context: the blocks of the terrain, meshed into the queue returned by
+// getChunkMeshes() for the renderer, and the dynamic entities, a falling cow and a leaf
+// following a Bézier curve by default. The camera itself is still the global
+// "camera"; input reaches it through the global command queue, drained at the
+// start of every tick.
+//
+// With a WorldStorage attached, chunks saved before replace the generated
+// ones as they are read, and the chunks edited since the last save() are
+// written back every AUTOSAVE_INTERVAL seconds of simulation. The chunks the
+// camera is moving towards are read ahead.
+//
+// Block edits, loaded chunks and torches change the light incrementally; it
+// is spread once per tick, before the dirty chunks are remeshed.
+//
+// The world only advances in ticks of SIMULATION_STEP seconds. The states of
+// the last two ticks are kept, so frames rendered in between can interpolate.
+class World {
+    private:
+        VoxelGrid voxels;
+        LightEngine lights;
+        TerrainGenerator generator;
+        GeneratorTimings generationTimings;
+
+        // Dirty chunks are remeshed at the end of every tick, on worker
+        // threads; "edited" tells whether any of them changed through
+        // setBlock() since then, first at "firstEditTime".
+        std::vector<ChunkMesher> meshers;
+        ChunkMeshQueue chunkMeshes;
+        std::vector<glm::ivec3> dirtyChunks;
+        std::vector<ChunkMesh> dirtyMeshes;
+        bool edited = false;
+        std::chrono::steady_clock::time_point firstEditTime;
+
+        // Chunks changed through setBlock() since the last save(), by key
+        WorldStorage* storage = NULL;
+        std::unordered_map<uint64_t, glm::ivec3> unsavedChunks;
+        std::vector<StoredChunk> loadedChunks;
+        double lastSaveTime = 0.0;
+        glm::ivec3 cameraChunk = glm::ivec3(0);
+
+        EntityStore entities;
+        SpatialHash broadphase = SpatialHash(BROADPHASE_CELL_SIZE);
+        std::vector<CandidatePair> candidatePairs;
+        EntityId cow;
+        EntityId leaf;
+
+        // Entities following Bézier curves at constant speed: curve i of
+        // "paths" moves pathEntities[i], which has covered pathProgress[i]
+        // of its length.
+        BezierBatch paths;
+        std::vector<EntityId> pathEntities;
+        std::vector<float> pathProgress;
+        std::vector<float> pathSpeeds;
+        std::vector<float> pathParameters;
+        std::vector<float> pathX, pathY, pathZ;
+
+        void updatePaths();
+
+        unsigned int seed;
+        double time = 0.0;
+
+        WorldState previousState;
+        WorldState currentState;
+
+        std::vector<Command> commands;
+        RaycastHit pickedBlock = {false, glm::ivec3(0), glm::ivec3(0), 0.0f};
+
+        Profiler& profiler;
+        int cameraPhase;
+        int entitiesPhase;
+        int collisionPhase;
+        int lightingPhase;
+        int meshingPhase;
+
+        void generateTerrain(GenerationCache* generationCache);
+        void captureState(WorldState& state);
+        void pick();
+        void loadChunks();
+        void adviseChunks();
+        void remeshChunks();
+        void applyCommands();
+        void updateCamera(double deltaTime);
+        void updateEntities(double deltaTime);
+        void updateCollisions();
+        void updateAnimations(double deltaTime);
+
+    public:
+        World(unsigned int seed, Profiler& profiler, GenerationCache* generationCache = NULL);
+        void spawnHerd(int count);
+        void addPathFollower(EntityId entity, glm::vec4 p0, glm::vec4 p1, glm::vec4 c0, glm::vec4 c1, float period);
+        void tick();
+        void setBlock(glm::ivec3 block, Block type);
+        void attachStorage(WorldStorage& storage);
+        void save();
+        ChunkMeshQueue& getChunkMeshes();
+        double getTime();
+        size_t getEntityCount();
+        size_t getBlockMemory();
+        const GeneratorTimings& getGenerationTimings();
+        RaycastHit getPickedBlock();
+        WorldState getState(float alpha);
+        const WorldState& getPreviousState();
+        const WorldState& getCurrentState();
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef WORLD_STORAGE_H
+#define WORLD_STORAGE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+#include "region_file.hpp"
+
+// A chunk read back from disk; NULL blocks mean only air
+struct StoredChunk {
+    glm::ivec3 chunk;
+    std::unique_ptr<Chunk> blocks;
+};
+
+// Payload of a chunk in a region file: the length of the serialized chunk,
+// then the serialized chunk compressed with zlib. Decoding fails on anything
+// else.
+void encodeChunk(const Chunk* blocks, std::vector<uint8_t>& payload);
+bool decodeChunk(const uint8_t* payload, size_t size, std::unique_ptr<Chunk>& blocks);
+
+// Saved world in a directory: the seed in "world.txt" and the edited chunks
+// in region files. Chunks are compressed, written and read on a background
+// thread, in the order they were requested; loaded chunks are picked up with
+// takeLoaded(). Chunks are decompressed straight from the mapped region
+// files, and requestAdvise() has their pages read ahead of the load. The
+// destructor finishes every pending request.
+class WorldStorage {
+    private:
+        enum RequestType { loadChunk, saveChunk, adviseChunk };
+
+        struct Request {
+            RequestType type;
+            glm::ivec3 chunk;
+            std::unique_ptr<Chunk> blocks;
+        };
+
+        std::string directory;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        std::deque<Request> requests;
+        std::vector<StoredChunk> loaded;
+        bool busy = false;
+        bool stopping = false;
+        std::thread thread;
+
+        // Only used by the background thread
+        std::unordered_map<uint64_t, std::unique_ptr<RegionFile>> regions;
+
+        RegionFile* getRegion(glm::ivec3 chunk, bool create);
+        void load(Request& request);
+        void save(Request& request);
+        void advise(Request& request);
+        void run();
+
+    public:
+        WorldStorage(const char* directory);
+        WorldStorage(const WorldStorage&) = delete;
+        WorldStorage& operator=(const WorldStorage&) = delete;
+        ~WorldStorage();
+
+        bool readSeed(unsigned int& seed);
+        bool writeSeed(unsigned int seed);
+
+        void requestLoad(glm::ivec3 chunk);
+        void requestSave(glm::ivec3 chunk, const Chunk* blocks);
+        void requestAdvise(glm::ivec3 chunk);
+        void takeLoaded(std::vector<StoredChunk>& taken);
+        void flush();
+};
+
+#endif
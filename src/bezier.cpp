@@ -1,5 +1,7 @@
 #include "bezier.hpp"
 
+#include <algorithm>
+
 glm::vec4 BezierCurve::calculate(glm::vec4 p0, glm::vec4 p1, glm::vec4 c0, glm::vec4 c1, float delta){
     glm::vec4 vecP0C0 = p0 + delta * (c0 - p0);
     glm::vec4 vecP1C1 = p1 + delta * (c1 - p1);
@@ -10,4 +12,114 @@ glm::vec4 BezierCurve::calculate(glm::vec4 p0, glm::vec4 p1, glm::vec4 c0, glm::
     glm::vec4 aux1 = vecP1C1 + delta * (vecC0C1 - vecP1C1);
 
     return aux0 + delta * (aux1 - aux0);
-};
\ No newline at end of file
+};
+
+// Expanding the lerps of calculate() gives the Bernstein like form
+//   (1-t)³ p0 + t(1-t)² p1 + t(1-t)(2-t) c0 + t²(2-t) c1
+// whose power basis coefficients are stored here.
+size_t BezierBatch::add(glm::vec4 p0, glm::vec4 p1, glm::vec4 c0, glm::vec4 c1){
+    glm::vec4 a = p0;
+    glm::vec4 b = -3.0f * p0 + p1 + 2.0f * c0;
+    glm::vec4 c = 3.0f * p0 - 2.0f * p1 - 3.0f * c0 + 2.0f * c1;
+    glm::vec4 d = -p0 + p1 + c0 - c1;
+
+    this->ax.push_back(a.x); this->ay.push_back(a.y); this->az.push_back(a.z);
+    this->bx.push_back(b.x); this->by.push_back(b.y); this->bz.push_back(b.z);
+    this->cx.push_back(c.x); this->cy.push_back(c.y); this->cz.push_back(c.z);
+    this->dx.push_back(d.x); this->dy.push_back(d.y); this->dz.push_back(d.z);
+
+    size_t curve = this->ax.size() - 1;
+
+    buildArcLengthTable(curve);
+
+    return curve;
+}
+
+// Samples the curve finely, accumulating chord lengths, then inverts the
+// accumulated length at ARC_LENGTH_SAMPLES evenly spaced fractions of it.
+void BezierBatch::buildArcLengthTable(size_t curve){
+    const int steps = ARC_LENGTH_SAMPLES * 8;
+
+    std::vector<glm::vec3> points(steps + 1);
+    std::vector<float> accumulated(steps + 1);
+
+    for (int i = 0; i <= steps; i++) points[i] = evaluateOne(curve, (float) i / steps);
+
+    accumulated[0] = 0.0f;
+    for (int i = 1; i <= steps; i++) accumulated[i] = accumulated[i - 1] + glm::distance(points[i - 1], points[i]);
+
+    float length = accumulated[steps];
+    this->lengths.push_back(length);
+
+    int step = 0;
+
+    for (int sample = 0; sample < ARC_LENGTH_SAMPLES; sample++) {
+        float target = length * sample / (ARC_LENGTH_SAMPLES - 1);
+
+        while (step < steps - 1 && accumulated[step + 1] < target) step++;
+
+        float span = accumulated[step + 1] - accumulated[step];
+        float blend = span > 0.0f ? std::min(std::max((target - accumulated[step]) / span, 0.0f), 1.0f) : 0.0f;
+
+        this->arcLengthTable.push_back((step + blend) / steps);
+    }
+}
+
+static inline float horner(float a, float b, float c, float d, float t){
+    return a + t * (b + t * (c + t * d));
+}
+
+glm::vec3 BezierBatch::evaluateOne(size_t curve, float t) const {
+    return glm::vec3(horner(this->ax[curve], this->bx[curve], this->cx[curve], this->dx[curve], t),
+                     horner(this->ay[curve], this->by[curve], this->cy[curve], this->dy[curve], t),
+                     horner(this->az[curve], this->bz[curve], this->cz[curve], this->dz[curve], t));
+}
+
+size_t BezierBatch::size() const {
+    return this->ax.size();
+}
+
+float BezierBatch::getLength(size_t curve) const {
+    return this->lengths[curve];
+}
+
+// Point of every curve i at parameters[i], all arrays holding size() values
+void BezierBatch::evaluate(const float* __restrict parameters, float* __restrict x, float* __restrict y, float* __restrict z) const {
+    const float* __restrict ax = this->ax.data();
+    const float* __restrict ay = this->ay.data();
+    const float* __restrict az = this->az.data();
+    const float* __restrict bx = this->bx.data();
+    const float* __restrict by = this->by.data();
+    const float* __restrict bz = this->bz.data();
+    const float* __restrict cx = this->cx.data();
+    const float* __restrict cy = this->cy.data();
+    const float* __restrict cz = this->cz.data();
+    const float* __restrict dx = this->dx.data();
+    const float* __restrict dy = this->dy.data();
+    const float* __restrict dz = this->dz.data();
+    size_t count = this->ax.size();
+
+    for (size_t i = 0; i < count; i++) {
+        float t = parameters[i];
+
+        x[i] = horner(ax[i], bx[i], cx[i], dx[i], t);
+        y[i] = horner(ay[i], by[i], cy[i], dy[i], t);
+        z[i] = horner(az[i], bz[i], cz[i], dz[i], t);
+    }
+}
+
+// Converts fractions[i] in [0, 1] of the length of curve i into its
+// parameter t, so equal steps of fraction cover equal distances.
+void BezierBatch::getParametersAtDistance(const float* fractions, float* parameters) const {
+    const float* table = this->arcLengthTable.data();
+    size_t count = this->ax.size();
+
+    for (size_t i = 0; i < count; i++) {
+        float position = std::min(std::max(fractions[i], 0.0f), 1.0f) * (ARC_LENGTH_SAMPLES - 1);
+        int sample = std::min((int) position, ARC_LENGTH_SAMPLES - 2);
+        float blend = position - sample;
+
+        const float* samples = table + i * ARC_LENGTH_SAMPLES + sample;
+        parameters[i] = samples[0] + blend * (samples[1] - samples[0]);
+    }
+}
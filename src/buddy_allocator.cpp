@@ -0,0 +1,107 @@
+#include "buddy_allocator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+size_t BuddyStats::getFree() const {
+    return this->capacity - this->allocated;
+}
+
+// How much of the free space cannot be handed out in one piece: 0 when it
+// is a single block, close to 1 when it is scattered in small blocks
+double BuddyStats::getFragmentation() const {
+    size_t free = getFree();
+
+    return free > 0 ? 1.0 - (double) this->largestFree / free : 0.0;
+}
+
+BuddyAllocator::BuddyAllocator(uint32_t capacity, uint32_t minimumBlock){
+    this->minimumBlock = minimumBlock;
+    this->orders = 1;
+
+    while (((uint64_t) minimumBlock << (this->orders - 1)) < capacity) this->orders++;
+
+    this->freeBlocks.resize(this->orders);
+    this->freeBlocks[this->orders - 1].insert(0);
+
+    this->stats.capacity = capacity;
+}
+
+// Smallest order whose blocks hold "size" units
+int BuddyAllocator::orderFor(uint32_t size) const {
+    int order = 0;
+
+    while (((uint64_t) this->minimumBlock << order) < size) order++;
+
+    return order;
+}
+
+// Sets "offset" to the first unit of a range of at least "size" units;
+// false when no free block is big enough
+bool BuddyAllocator::allocate(uint32_t size, uint32_t& offset){
+    int order = orderFor(size > 0 ? size : 1);
+    int found = order;
+
+    while (found < this->orders && this->freeBlocks[found].empty()) found++;
+
+    if (found >= this->orders) return false;
+
+    offset = *this->freeBlocks[found].begin();
+    this->freeBlocks[found].erase(this->freeBlocks[found].begin());
+
+    // The upper halves of the splits stay free
+    while (found > order) {
+        found--;
+        this->freeBlocks[found].insert(offset + (this->minimumBlock << found));
+    }
+
+    this->allocations[offset] = {order, size};
+
+    this->stats.requested += size;
+    this->stats.allocated += (size_t) this->minimumBlock << order;
+    this->stats.allocations++;
+
+    return true;
+}
+
+void BuddyAllocator::free(uint32_t offset){
+    auto allocation = this->allocations.find(offset);
+
+    if (allocation == this->allocations.end()) {
+        fprintf(stderr, "ERROR: Freeing a range that was never allocated.\n");
+        return;
+    }
+
+    int order = allocation->second.order;
+
+    this->stats.requested -= allocation->second.size;
+    this->stats.allocated -= (size_t) this->minimumBlock << order;
+    this->stats.allocations--;
+    this->allocations.erase(allocation);
+
+    while (order < this->orders - 1) {
+        uint32_t buddy = offset ^ (this->minimumBlock << order);
+        auto free = this->freeBlocks[order].find(buddy);
+
+        if (free == this->freeBlocks[order].end()) break;
+
+        this->freeBlocks[order].erase(free);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+
+    this->freeBlocks[order].insert(offset);
+}
+
+const BuddyStats& BuddyAllocator::getStats(){
+    this->stats.largestFree = 0;
+
+    for (int order = this->orders - 1; order >= 0; order--) {
+        if (!this->freeBlocks[order].empty()) {
+            this->stats.largestFree = (size_t) this->minimumBlock << order;
+            break;
+        }
+    }
+
+    return this->stats;
+}
@@ -39,8 +39,15 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods){
             // com o botão esquerdo pressionado.
             glfwGetCursorPos(window, &g_LastCursorPosX, &g_LastCursorPosY);
             g_LeftMouseButtonPressed = true;
+
+            // Removes the block under the crosshair
+            inputCommands.push({breakBlock});
         }
     }
+    if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS && windowIsFocused){
+        // Places a block against the face under the crosshair
+        inputCommands.push({placeBlock});
+    }
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE){
         // Quando o usuário soltar o botão esquerdo do mouse, atualizamos a
         // variável abaixo para false.
@@ -63,7 +70,10 @@ void CursorPosCallback(GLFWwindow* window, double xpos, double ypos){
     float dx = xpos - g_LastCursorPosX;
     float dy = ypos - g_LastCursorPosY;
 
-    camera.updateMouse(dx, dy);
+    Command command = {rotateCamera};
+    command.dx = dx;
+    command.dy = dy;
+    inputCommands.push(command);
 
     // Atualizamos as variáveis globais para armazenar a posição atual do
     // cursor como sendo a última posição conhecida do cursor.
@@ -77,9 +87,10 @@ void CursorPosCallback(GLFWwindow* window, double xpos, double ypos){
 void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset){
     // Atualizamos a distância da câmera para a origem utilizando a
     // movimentação da "rodinha", simulando um ZOOM.
-    float dy = 0.1f * yoffset;
+    Command command = {zoomCamera};
+    command.dy = 0.1f * yoffset;
 
-    camera.updateDistance(dy);
+    inputCommands.push(command);
 }
 
 // Definição da função que será chamada sempre que o usuário pressionar alguma
@@ -89,18 +100,29 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
 
-    camera.setUpdatingPosition(none);
+    // The camera and the cow belong to the simulation thread, which applies
+    // these commands on its next tick.
+    Command move = {moveCamera};
+
+    if (key == GLFW_KEY_W && (action == GLFW_PRESS || action == GLFW_REPEAT)) move.direction = up;
+    else if (key == GLFW_KEY_S && (action == GLFW_PRESS || action == GLFW_REPEAT)) move.direction = down;
+    else if (key == GLFW_KEY_A && (action == GLFW_PRESS || action == GLFW_REPEAT)) move.direction = left;
+    else if (key == GLFW_KEY_D && (action == GLFW_PRESS || action == GLFW_REPEAT)) move.direction = right;
+
+    inputCommands.push(move);
 
     // Se o usuário apertar a tecla P, utilizamos projeção perspectiva.
-    if (key == GLFW_KEY_P && action == GLFW_PRESS) camera.changeMode();
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) inputCommands.push({changeCameraMode});
+
+    // T places a torch against the block looked at, or takes it back
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) inputCommands.push({toggleTorch});
+
+    Command rotate = {rotateCow};
 
-    if (key == GLFW_KEY_W && (action == GLFW_PRESS || action == GLFW_REPEAT)) camera.setUpdatingPosition(up);
-    else if (key == GLFW_KEY_S && (action == GLFW_PRESS || action == GLFW_REPEAT)) camera.setUpdatingPosition(down);
-    else if (key == GLFW_KEY_A && (action == GLFW_PRESS || action == GLFW_REPEAT)) camera.setUpdatingPosition(left);
-    else if (key == GLFW_KEY_D && (action == GLFW_PRESS || action == GLFW_REPEAT)) camera.setUpdatingPosition(right);
+    if (key == GLFW_KEY_K && (action == GLFW_PRESS || action == GLFW_REPEAT)) rotate.dy = 0.1f;
+    if (key == GLFW_KEY_J && (action == GLFW_PRESS || action == GLFW_REPEAT)) rotate.dy = -0.1f;
 
-    if (key == GLFW_KEY_K && (action == GLFW_PRESS || action == GLFW_REPEAT)) cowRotate.y+=0.1f;
-    if (key == GLFW_KEY_J && (action == GLFW_PRESS || action == GLFW_REPEAT)) cowRotate.y-=0.1f;
+    if (rotate.dy != 0.0f) inputCommands.push(rotate);
 }
 
 // Definimos o callback para impressão de erros da GLFW no terminal
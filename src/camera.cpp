@@ -6,10 +6,16 @@
 const float phimax = 3.141592f / 2;
 const float phimin = -phimax;
 
+// Box of the free camera against the blocks: the eye stands 1.5 above the
+// bottom, which keeps it as high over a block as it always was.
+const glm::vec3 bodyBelow = glm::vec3(0.3f, 1.5f, 0.3f);
+const glm::vec3 bodyAbove = glm::vec3(0.3f, 0.2f, 0.3f);
+
 Camera::Camera(float speed, float distance, glm::vec4 positionFree, glm::vec4 positionLook, glm::vec4 viewFree, glm::vec4 viewLook){
     this->speed = speed;
     this->distance = distance;
     this->positionFree = positionFree;
+    this->previousFree = positionFree;
     this->positionLook = positionLook;
     this->viewFree = viewFree;
     this->viewLook = viewLook;
@@ -19,10 +25,12 @@ void Camera::setUpdatingPosition(Direction direction){
     this->updatingPosition = direction;
 }
 
-void Camera::move(){
+void Camera::move(double deltaTime){
     Direction direction = this->updatingPosition;
 
-    if (direction == none) return;
+    this->previousFree = this->positionFree;
+
+    if (!this->isFree || direction == none) return;
 
     glm::vec4 w = -this->viewFree / norm(-this->viewFree);
     glm::vec4 u = crossproduct(this->upVector, w) / norm(crossproduct(this->upVector, w));
@@ -34,9 +42,29 @@ void Camera::move(){
         case(right): this->positionFree += u * (float)(deltaTime * this->speed); break;
         default: break;
     }
+}
+
+// Only a moving free camera can run into the map or the entities
+void Camera::collide(const VoxelGrid& voxels, const EntityStore& entities, const SpatialHash& broadphase){
+    if (!this->isFree || this->updatingPosition == none) return;
+
+    // The whole step is swept from where the camera was, so it cannot go
+    // through a block however fast it moves.
+    glm::vec3 eye = glm::vec3(this->previousFree);
+    Aabb body = {eye - bodyBelow, eye + bodyAbove};
+    SweepResult sweep = sweepAabb(voxels, body, glm::vec3(this->positionFree - this->previousFree));
+
+    this->positionFree = this->previousFree + glm::vec4(sweep.displacement, 0.0f);
+
+    // Outside of the grid there is nothing to collide with, so the camera is
+    // kept over the map
+    glm::vec3 low = glm::vec3(voxels.getOrigin());
+    glm::vec3 high = low + glm::vec3(voxels.getSize());
+
+    this->positionFree.x = glm::clamp(this->positionFree.x, low.x, high.x);
+    this->positionFree.z = glm::clamp(this->positionFree.z, low.z, high.z);
 
-    collideCameraWithMap(this->positionFree, mapData);
-    collideCameraWithCow(this->positionFree, cowPosition);
+    collideCameraWithEntities(this->positionFree, this->previousFree, entities, broadphase, this->entityCandidates);
 }
 
 float Camera::returnX(){
@@ -108,7 +136,6 @@ glm::mat4 Camera::getView(){
     glm::mat4 view;
 
     if (this->isFree){
-        this->move();
         view = this->getViewFree();
     } else {
         view = this->getViewLook();
@@ -117,6 +144,27 @@ glm::mat4 Camera::getView(){
     return view;
 }
 
+// Position and view vector of the active mode, as of the last getView()
+glm::vec4 Camera::getPosition(){
+    return this->isFree ? this->positionFree : this->positionLook;
+}
+
+glm::vec4 Camera::getDirection(){
+    return this->isFree ? this->viewFree : this->viewLook;
+}
+
+bool Camera::getIsFree(){
+    return this->isFree;
+}
+
+// Places the free camera directly, used by scripted camera paths
+void Camera::setFreePose(glm::vec4 position, float phi, float tetha){
+    this->positionFree = position;
+    this->previousFree = position;
+    this->phiFree = phi;
+    this->tethaFree = tetha;
+}
+
 void Camera::changeMode(){
     this->isFree = !this->isFree;
 }
@@ -0,0 +1,234 @@
+#include "chunk.hpp"
+
+#include <algorithm>
+
+// y major, then z, then x
+int Chunk::indexOf(glm::ivec3 local){
+    return (local.y * CHUNK_SIZE + local.z) * CHUNK_SIZE + local.x;
+}
+
+// Fewest bits for indices into a palette of "size" kinds
+static int bitsFor(size_t size){
+    if (size <= 1) return 0;
+    if (size <= 2) return 1;
+    if (size <= 4) return 2;
+    if (size <= 16) return 4;
+    if (size <= 256) return 8;
+    return 16;
+}
+
+// Words hold 1 << wordShift indices, so they are found with shifts and masks
+static int wordShiftFor(int bits){
+    switch(bits){
+        case(1): return 6;
+        case(2): return 5;
+        case(4): return 4;
+        case(8): return 3;
+        case(16): return 2;
+        default: return 0;
+    }
+}
+
+int Chunk::getIndex(int i) const {
+    if (this->bits == 0) return 0;
+
+    uint64_t word = this->words[i >> this->wordShift];
+    int shift = (i & ((1 << this->wordShift) - 1)) * this->bits;
+
+    return (word >> shift) & ((1u << this->bits) - 1);
+}
+
+void Chunk::setIndex(int i, int index){
+    int shift = (i & ((1 << this->wordShift) - 1)) * this->bits;
+    uint64_t mask = (((uint64_t) 1 << this->bits) - 1) << shift;
+    uint64_t& word = this->words[i >> this->wordShift];
+
+    word = (word & ~mask) | ((uint64_t) index << shift);
+}
+
+// Index of "block" in the palette, adding it, and widening the indices if
+// it does not fit
+int Chunk::addToPalette(Block block){
+    int unused = -1;
+
+    for (size_t index = 0; index < this->palette.size(); index++) {
+        if (this->palette[index] == block) return index;
+        if (this->counts[index] == 0 && unused < 0) unused = index;
+    }
+
+    if (unused >= 0) {
+        this->palette[unused] = block;
+        return unused;
+    }
+
+    this->palette.push_back(block);
+    this->counts.push_back(0);
+
+    if (bitsFor(this->palette.size()) > this->bits) repack(bitsFor(this->palette.size()));
+
+    return this->palette.size() - 1;
+}
+
+void Chunk::repack(int bits){
+    std::vector<int> indices(CHUNK_VOLUME);
+    for (int i = 0; i < CHUNK_VOLUME; i++) indices[i] = getIndex(i);
+
+    this->bits = bits;
+    this->wordShift = wordShiftFor(bits);
+    this->words.assign(bits == 0 ? 0 : CHUNK_VOLUME >> this->wordShift, 0);
+
+    if (bits == 0) return;
+    for (int i = 0; i < CHUNK_VOLUME; i++) setIndex(i, indices[i]);
+}
+
+Block Chunk::get(glm::ivec3 local) const {
+    return this->palette[getIndex(indexOf(local))];
+}
+
+void Chunk::set(glm::ivec3 local, Block block){
+    int i = indexOf(local);
+    int current = getIndex(i);
+
+    if (this->palette[current] == block) return;
+
+    this->solidCount += (block != air) - (this->palette[current] != air);
+
+    int index = addToPalette(block);
+    setIndex(i, index);
+
+    this->counts[current]--;
+    this->counts[index]++;
+
+    // Back to a single kind of block
+    if (this->counts[index] == CHUNK_VOLUME) {
+        this->palette.assign(1, block);
+        this->counts.assign(1, CHUNK_VOLUME);
+        this->words.clear();
+        this->words.shrink_to_fit();
+        this->bits = 0;
+        this->wordShift = 0;
+    }
+}
+
+// The blocks of layers "firstLayer" to "lastLayer", every layer by default,
+// at their index in "blocks", one word at a time
+void Chunk::unpack(Block* blocks, int firstLayer, int lastLayer) const {
+    blocks += firstLayer * CHUNK_SIZE * CHUNK_SIZE;
+
+    if (this->bits == 0) {
+        std::fill(blocks, blocks + (lastLayer - firstLayer + 1) * CHUNK_SIZE * CHUNK_SIZE, this->palette[0]);
+        return;
+    }
+
+    int perWord = 1 << this->wordShift;
+    uint64_t mask = ((uint64_t) 1 << this->bits) - 1;
+
+    // A layer always spans whole words
+    size_t first = (size_t) (firstLayer * CHUNK_SIZE * CHUNK_SIZE) >> this->wordShift;
+    size_t last = (size_t) ((lastLayer + 1) * CHUNK_SIZE * CHUNK_SIZE) >> this->wordShift;
+
+    for (size_t w = first; w < last; w++) {
+        uint64_t word = this->words[w];
+
+        for (int j = 0; j < perWord; j++) {
+            *blocks++ = this->palette[word & mask];
+            word >>= this->bits;
+        }
+    }
+}
+
+bool Chunk::isEmpty() const {
+    return this->solidCount == 0;
+}
+
+// Bytes used by the chunk and its arrays
+size_t Chunk::getMemoryUsage() const {
+    return sizeof(Chunk) + this->palette.capacity() * sizeof(Block) +
+           this->counts.capacity() * sizeof(uint16_t) + this->words.capacity() * sizeof(uint64_t);
+}
+
+void Chunk::serialize(std::vector<uint8_t>& data) const {
+    size_t paletteSize = this->palette.size();
+
+    data.resize(3 + paletteSize * 2 + this->words.size() * 8);
+    data[0] = this->bits;
+    data[1] = paletteSize & 0xff;
+    data[2] = paletteSize >> 8;
+
+    uint8_t* next = &data[3];
+
+    for (Block block : this->palette) {
+        *next++ = block & 0xff;
+        *next++ = block >> 8;
+    }
+
+    for (uint64_t word : this->words) {
+        for (int byte = 0; byte < 8; byte++) *next++ = (word >> (byte * 8)) & 0xff;
+    }
+}
+
+// Fails, leaving the chunk as it was, if "data" is not a whole chunk of
+// known blocks
+bool Chunk::deserialize(const uint8_t* data, size_t size){
+    if (size < 3) return false;
+
+    int bits = data[0];
+    size_t paletteSize = data[1] | (data[2] << 8);
+
+    if (paletteSize == 0 || paletteSize > CHUNK_VOLUME || bits != bitsFor(paletteSize)) return false;
+
+    size_t wordCount = bits == 0 ? 0 : CHUNK_VOLUME >> wordShiftFor(bits);
+    if (size != 3 + paletteSize * 2 + wordCount * 8) return false;
+
+    Chunk chunk;
+    chunk.bits = bits;
+    chunk.wordShift = wordShiftFor(bits);
+    chunk.palette.resize(paletteSize);
+    chunk.counts.assign(paletteSize, 0);
+    chunk.words.resize(wordCount);
+
+    const uint8_t* next = data + 3;
+
+    for (Block& block : chunk.palette) {
+        block = next[0] | (next[1] << 8);
+        next += 2;
+
+        if (block >= BLOCK_TYPES) return false;
+    }
+
+    for (uint64_t& word : chunk.words) {
+        word = 0;
+        for (int byte = 0; byte < 8; byte++) word |= (uint64_t) *next++ << (byte * 8);
+    }
+
+    for (int i = 0; i < CHUNK_VOLUME; i++) {
+        size_t index = chunk.getIndex(i);
+        if (index >= paletteSize) return false;
+
+        chunk.counts[index]++;
+        chunk.solidCount += chunk.palette[index] != air;
+    }
+
+    *this = std::move(chunk);
+
+    return true;
+}
+
+// Rounds down, also for negative values; "divisor" must be positive
+int floorDivide(int value, int divisor){
+    return value >= 0 ? value / divisor : (value - (divisor - 1)) / divisor;
+}
+
+glm::ivec3 getChunkOf(glm::ivec3 block){
+    return glm::ivec3(floorDivide(block.x, CHUNK_SIZE), floorDivide(block.y, CHUNK_SIZE), floorDivide(block.z, CHUNK_SIZE));
+}
+
+glm::ivec3 getLocalOf(glm::ivec3 block){
+    return block - getChunkOf(block) * CHUNK_SIZE;
+}
+
+uint64_t getChunkKey(glm::ivec3 chunk){
+    const uint64_t mask = (1 << 21) - 1;
+
+    return ((uint64_t) chunk.x & mask) | (((uint64_t) chunk.y & mask) << 21) | (((uint64_t) chunk.z & mask) << 42);
+}
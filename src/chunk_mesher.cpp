@@ -0,0 +1,238 @@
+#include "chunk_mesher.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// One face of the unit cube: its normal and its corners, counter clockwise
+// seen from outside, with their texture coordinates. Side textures are
+// upright.
+struct CubeFace {
+    glm::ivec3 normal;
+    glm::vec3 corners[4];
+    glm::vec2 textureCoords[4];
+};
+
+static const CubeFace cubeFaces[6] = {
+    // front face (+z)
+    {glm::ivec3(0, 0, 1), {glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.5f, 0.5f, 0.5f)},
+     {glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f)}},
+    // right face (+x)
+    {glm::ivec3(1, 0, 0), {glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.5f, 0.5f, -0.5f)},
+     {glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f)}},
+    // back face (-z)
+    {glm::ivec3(0, 0, -1), {glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, 0.5f, -0.5f)},
+     {glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f)}},
+    // left face (-x)
+    {glm::ivec3(-1, 0, 0), {glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(-0.5f, 0.5f, 0.5f)},
+     {glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f)}},
+    // top face (+y)
+    {glm::ivec3(0, 1, 0), {glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.5f, 0.5f, -0.5f)},
+     {glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f)}},
+    // bottom face (-y)
+    {glm::ivec3(0, -1, 0), {glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.5f, -0.5f, 0.5f)},
+     {glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f)}},
+};
+
+// Texture of every face of every block type, in the order of cubeFaces
+static const TerrainTexture faceTextures[BLOCK_TYPES][6] = {
+    {dirtTexture, dirtTexture, dirtTexture, dirtTexture, dirtTexture, dirtTexture}, // air, never drawn
+    {grassSideTexture, grassSideTexture, grassSideTexture, grassSideTexture, grassTopTexture, dirtTexture}, // grass
+    {dirtTexture, dirtTexture, dirtTexture, dirtTexture, dirtTexture, dirtTexture}, // dirt
+    {stoneTexture, stoneTexture, stoneTexture, stoneTexture, stoneTexture, stoneTexture}, // stone
+};
+
+// Shading of the terrain for a light direction and a material, the same as
+// the per fragment shading it replaces
+static const glm::vec3 lightDirection = glm::normalize(glm::vec3(1.0f, 1.0f, 0.5f));
+static const glm::vec3 diffuseColor = glm::vec3(0.5f, 0.4f, 0.08f);
+static const glm::vec3 ambientColor = glm::vec3(0.2f, 0.1f, 0.02f);
+
+// Brightness of every light level, 0.08 + 0.92 * 0.8^(MAX_LIGHT - level): each
+// level lost takes a fifth of the light, down to a floor so caves are not
+// pitch black
+static const float levelBrightness[MAX_LIGHT + 1] = {
+    0.112f, 0.120f, 0.131f, 0.143f, 0.159f, 0.179f, 0.203f, 0.234f,
+    0.273f, 0.321f, 0.381f, 0.457f, 0.551f, 0.669f, 0.816f, 1.000f
+};
+
+// Brightness of a vertex by occlusion, from 0 (most occluded) to 3 (none)
+static const float occlusionBrightness[4] = {0.45f, 0.65f, 0.82f, 1.0f};
+
+// Distance between neighbouring blocks in "blocks", per axis
+static const int paddedStrides[3] = {1, PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE, PADDED_CHUNK_SIZE};
+
+static inline int paddedIndex(int x, int y, int z){
+    return ((y + MESH_MARGIN) * PADDED_CHUNK_SIZE + (z + MESH_MARGIN)) * PADDED_CHUNK_SIZE + (x + MESH_MARGIN);
+}
+
+static inline int paddedOffset(glm::ivec3 offset){
+    return offset.x * paddedStrides[0] + offset.y * paddedStrides[1] + offset.z * paddedStrides[2];
+}
+
+// Every chunk the padded box overlaps is unpacked at once, only the layers
+// inside the box; chunks of only air are just filled. Light is copied along,
+// as the brightest of its channels.
+void ChunkMesher::copyBlocks(const VoxelGrid& voxels, const LightEngine& lights, glm::ivec3 chunk){
+    glm::ivec3 offset;
+
+    for (offset.y = -1; offset.y <= 1; offset.y++) {
+        for (offset.z = -1; offset.z <= 1; offset.z++) {
+            for (offset.x = -1; offset.x <= 1; offset.x++) {
+                const Chunk* blocks = voxels.getChunk(chunk + offset);
+                const uint8_t* light = lights.getChunkLight(chunk + offset);
+
+                // Part of the neighbour inside the box, in its own coordinates
+                glm::ivec3 first = glm::max(glm::ivec3(-MESH_MARGIN) - offset * CHUNK_SIZE, glm::ivec3(0));
+                glm::ivec3 last = glm::min(glm::ivec3(CHUNK_SIZE + MESH_MARGIN - 1) - offset * CHUNK_SIZE, glm::ivec3(CHUNK_SIZE - 1));
+
+                if (blocks != NULL) blocks->unpack(this->unpacked, first.y, last.y);
+                else std::fill(this->unpacked, this->unpacked + CHUNK_VOLUME, (Block) air);
+
+                for (int y = first.y; y <= last.y; y++) {
+                    for (int z = first.z; z <= last.z; z++) {
+                        glm::ivec3 padded = offset * CHUNK_SIZE + glm::ivec3(first.x, y, z);
+                        int from = Chunk::indexOf(glm::ivec3(first.x, y, z));
+                        int to = paddedIndex(padded.x, padded.y, padded.z);
+                        int length = last.x - first.x + 1;
+
+                        std::copy(this->unpacked + from, this->unpacked + from + length, this->blocks + to);
+
+                        // Out of the grid, there is only sky
+                        for (int x = 0; x < length; x++) {
+                            this->light[to + x] = light != NULL ? std::max(light[from + x] >> 4, light[from + x] & 0x0f) : MAX_LIGHT;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Brightness of the corner of the face of block "index" facing "normal",
+// and how many of the three blocks around the corner in front of the face
+// let the light through (3 for none occluding)
+float ChunkMesher::bakeVertex(int index, glm::ivec3 normal, glm::vec3 corner, int& occlusion){
+    int axis = normal.x != 0 ? 0 : normal.y != 0 ? 1 : 2;
+    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+    int front = index + paddedOffset(normal);
+    int side1 = front + (corner[u] > 0.0f ? 1 : -1) * paddedStrides[u];
+    int side2 = front + (corner[v] > 0.0f ? 1 : -1) * paddedStrides[v];
+    int diagonal = side1 + side2 - front;
+
+    bool solid1 = this->blocks[side1] != air;
+    bool solid2 = this->blocks[side2] != air;
+    bool solidDiagonal = this->blocks[diagonal] != air;
+
+    // Light cannot get to the diagonal block between two solid ones
+    if (solid1 && solid2) solidDiagonal = true;
+
+    occlusion = solid1 && solid2 ? 0 : 3 - (solid1 + solid2 + solidDiagonal);
+
+    float sum = levelBrightness[this->light[front]];
+    int count = 1;
+
+    if (!solid1) { sum += levelBrightness[this->light[side1]]; count++; }
+    if (!solid2) { sum += levelBrightness[this->light[side2]]; count++; }
+    if (!solidDiagonal) { sum += levelBrightness[this->light[diagonal]]; count++; }
+
+    return sum / count * occlusionBrightness[occlusion];
+}
+
+void ChunkMesher::mesh(const VoxelGrid& voxels, const LightEngine& lights, glm::ivec3 chunk, ChunkMesh& mesh){
+    mesh.chunk = chunk;
+    mesh.vertices.clear();
+    mesh.indices.clear();
+
+    if (voxels.getChunk(chunk) != NULL) {
+        copyBlocks(voxels, lights, chunk);
+
+        glm::vec3 base = glm::vec3(chunk * CHUNK_SIZE);
+
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int z = 0; z < CHUNK_SIZE; z++) {
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    int index = paddedIndex(x, y, z);
+                    Block block = this->blocks[index];
+                    if (block == air) continue;
+
+                    for (int f = 0; f < 6; f++) {
+                        const CubeFace& face = cubeFaces[f];
+                        glm::ivec3 n = face.normal;
+
+                        if (this->blocks[index + paddedOffset(n)] != air) continue;
+
+                        uint32_t first = (uint32_t) mesh.vertices.size();
+                        glm::vec3 center = base + glm::vec3(x, y, z);
+                        glm::vec3 shading = ambientColor + diffuseColor * std::max(0.0f, glm::dot(glm::vec3(n), lightDirection));
+                        uint8_t layer = (uint8_t) faceTextures[block][f];
+                        int occlusions[4];
+
+                        for (int corner = 0; corner < 4; corner++) {
+                            glm::vec3 position = center + face.corners[corner];
+                            glm::vec3 color = shading * bakeVertex(index, n, face.corners[corner], occlusions[corner]);
+
+                            TerrainVertex vertex = {
+                                {position.x, position.y, position.z},
+                                {(int8_t) (n.x * 127), (int8_t) (n.y * 127), (int8_t) (n.z * 127)},
+                                layer,
+                                {face.textureCoords[corner].x, face.textureCoords[corner].y},
+                                {(uint8_t) (color.r * 255.0f + 0.5f), (uint8_t) (color.g * 255.0f + 0.5f), (uint8_t) (color.b * 255.0f + 0.5f), 255}
+                            };
+
+                            mesh.vertices.push_back(vertex);
+                        }
+
+                        std::vector<uint32_t>& indices = mesh.indices;
+
+                        if (occlusions[0] + occlusions[2] >= occlusions[1] + occlusions[3]) {
+                            indices.insert(indices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+                        } else {
+                            indices.insert(indices.end(), {first + 1, first + 2, first + 3, first + 1, first + 3, first});
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void meshChunks(const VoxelGrid& voxels, const LightEngine& lights, const std::vector<glm::ivec3>& chunks,
+                std::vector<ChunkMesher>& meshers, std::vector<ChunkMesh>& meshes){
+    meshes.clear();
+    meshes.resize(chunks.size());
+
+    unsigned int threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int) chunks.size()));
+    if (meshers.size() < threadCount) meshers.resize(threadCount);
+
+    std::atomic<size_t> next(0);
+
+    // Threads take the next chunk until there are none left
+    auto work = [&](ChunkMesher& mesher){
+        for (size_t i = next++; i < chunks.size(); i = next++) mesher.mesh(voxels, lights, chunks[i], meshes[i]);
+    };
+
+    std::vector<std::thread> threads;
+
+    for (unsigned int t = 1; t < threadCount; t++) threads.emplace_back(work, std::ref(meshers[t]));
+    work(meshers[0]);
+
+    for (std::thread& thread : threads) thread.join();
+}
+
+void ChunkMeshQueue::push(ChunkMesh&& mesh){
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->meshes.push_back(std::move(mesh));
+}
+
+// Moves every pending mesh to "drained", oldest first
+void ChunkMeshQueue::drain(std::vector<ChunkMesh>& drained){
+    drained.clear();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    drained.swap(this->meshes);
+}
@@ -2,76 +2,47 @@
 
 #include "globals.hpp"
 
-// map block collision
-#define DISTANCE 2.0f
-
-// point-cube collision
-void collideCameraWithMap(glm::vec4 & position,
-    glm::vec4 mapData[MAP_SIZE][MAP_SIZE]) {
-    int max_coord = MAP_SIZE / 2;
-    int x = static_cast < int > (floor(position.x)) + max_coord;
-    int z = static_cast < int > (floor(position.z)) + max_coord;
+// point-sphere collision against the entities near the camera: a camera
+// inside one goes back to "previousPosition". "candidates" is scratch memory
+// kept by the caller between calls.
+void collideCameraWithEntities(glm::vec4 & cameraPosition, glm::vec4 previousPosition, const EntityStore & entities,
+                               const SpatialHash & broadphase, std::vector<uint32_t> & candidates) {
+    glm::vec3 cameraPos = glm::vec3(cameraPosition);
 
-    if (x < 0) {
-        position.x = -max_coord;
-    } else if (x >= MAP_SIZE) {
-        position.x = max_coord;
-    } else if (z < 0) {
-        position.z = -max_coord;
-    } else if (z >= MAP_SIZE) {
-        position.z = max_coord;
-    } else {
-        float blockTop = mapData[x][z].y + DISTANCE;
-        if (position.y < blockTop) {
-            position.y = blockTop;
-        } else {
-            float blockLeft = mapData[x][z].x;
-            float blockRight = blockLeft + DISTANCE;
-            float blockFront = mapData[x][z].z;
-            float blockBack = blockFront + DISTANCE;
+    candidates.clear();
+    broadphase.query(cameraPos, 0.0f, candidates);
 
-            if (position.x < blockLeft) {
-                position.x = blockLeft;
-            } else if (position.x > blockRight) {
-                position.x = blockRight;
-            }
+    for (uint32_t i : candidates) {
+        float radius = entities.colliders[i].radius;
+        glm::vec3 offset = cameraPos - entities.positions[i];
 
-            if (position.z < blockFront) {
-                position.z = blockFront;
-            } else if (position.z > blockBack) {
-                position.z = blockBack;
-            }
+        if (glm::dot(offset, offset) < radius * radius) {
+            cameraPosition = previousPosition;
+            return;
         }
     }
 }
 
-// point-sphere collision
-glm::vec4 previousCameraPosition;
-void collideCameraWithCow(glm::vec4 & cameraPosition, glm::vec3 & cowPosition) {
-    // posicao da camera interna da funcao
-    glm::vec3 cameraPos = glm::vec3(cameraPosition);
+// sphere-sphere collision: overlapping entities are pushed apart
+// horizontally, each one by half of the overlap.
+void separateEntities(EntityStore & entities, const std::vector<CandidatePair> & pairs) {
+    glm::vec3* positions = entities.positions.data();
+    const Collider* colliders = entities.colliders.data();
 
-    // posicao da vaca e estimativa do bounding box
-    glm::vec3 cowPos = glm::vec3(cowPosition);
-    float cowRadius = 1.5f;
+    for (const CandidatePair& pair : pairs) {
+        glm::vec3 offset = positions[pair.second] - positions[pair.first];
+        float reach = colliders[pair.first].radius + colliders[pair.second].radius;
 
-    // Checa colisao da vaca com esfera de hit
-    if (glm::distance(cameraPos, cowPos) < cowRadius) {
-        cameraPosition = previousCameraPosition;
-    } else {
-        previousCameraPosition = cameraPosition;
-    }
+        if (glm::dot(offset, offset) >= reach * reach) continue;
 
-}
+        offset.y = 0.0f;
+        float distance = glm::length(offset);
 
-// cube-cube collision
-bool collideCowWithMap(glm::vec3 cowPosition, glm::vec4 mapData[64][64]) {
-    int x = (int) floor(cowPosition.x);
-    int z = (int) floor(cowPosition.z);
+        // Entities right on top of each other part along x
+        glm::vec3 direction = distance > 0.0001f ? offset / distance : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 push = direction * (0.5f * (reach - distance));
 
-    if (cowPosition.y <= mapData[x + MAP_SIZE / 2][z + MAP_SIZE / 2].y + 1.5f) {
-        return true;
+        positions[pair.first] -= push;
+        positions[pair.second] += push;
     }
-
-    return false;
-}
\ No newline at end of file
+}
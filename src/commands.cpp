@@ -0,0 +1,16 @@
+#include "commands.hpp"
+
+void CommandQueue::push(const Command& command){
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->commands.push_back(command);
+}
+
+// Moves every pending command to "drained", keeping both allocations alive
+void CommandQueue::drain(std::vector<Command>& drained){
+    drained.clear();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    drained.swap(this->commands);
+}
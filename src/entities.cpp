@@ -0,0 +1,131 @@
+#include "entities.hpp"
+
+#include <algorithm>
+
+#include "voxel_grid.hpp"
+
+EntityId EntityStore::create(Mesh mesh, glm::vec3 position, float rotation, glm::vec3 velocity, Collider collider){
+    EntityId id = (EntityId) this->indices.size();
+
+    this->indices.push_back((uint32_t) this->ids.size());
+    this->ids.push_back(id);
+
+    this->positions.push_back(position);
+    this->rotations.push_back(rotation);
+    this->velocities.push_back(velocity);
+    this->meshes.push_back(mesh);
+    this->colliders.push_back(collider);
+
+    return id;
+}
+
+// Swaps the entity with the last one, then shrinks every array
+void EntityStore::destroy(EntityId id){
+    if (!isAlive(id)) return;
+
+    size_t index = this->indices[id];
+    size_t last = this->ids.size() - 1;
+
+    if (index != last){
+        EntityId moved = this->ids[last];
+
+        this->ids[index] = moved;
+        this->positions[index] = this->positions[last];
+        this->rotations[index] = this->rotations[last];
+        this->velocities[index] = this->velocities[last];
+        this->meshes[index] = this->meshes[last];
+        this->colliders[index] = this->colliders[last];
+
+        this->indices[moved] = (uint32_t) index;
+    }
+
+    this->ids.pop_back();
+    this->positions.pop_back();
+    this->rotations.pop_back();
+    this->velocities.pop_back();
+    this->meshes.pop_back();
+    this->colliders.pop_back();
+
+    this->indices[id] = INVALID_INDEX;
+}
+
+bool EntityStore::isAlive(EntityId id) const {
+    return id < this->indices.size() && this->indices[id] != INVALID_INDEX;
+}
+
+size_t EntityStore::indexOf(EntityId id) const {
+    return this->indices[id];
+}
+
+size_t EntityStore::size() const {
+    return this->ids.size();
+}
+
+const std::vector<EntityId>& EntityStore::getIds() const {
+    return this->ids;
+}
+
+void EntityStore::reserve(size_t count){
+    this->ids.reserve(count);
+    this->positions.reserve(count);
+    this->rotations.reserve(count);
+    this->velocities.reserve(count);
+    this->meshes.reserve(count);
+    this->colliders.reserve(count);
+}
+
+void integrateVelocities(EntityStore& entities, float deltaTime){
+    glm::vec3* positions = entities.positions.data();
+    const glm::vec3* velocities = entities.velocities.data();
+    size_t count = entities.size();
+
+    for (size_t i = 0; i < count; i++) positions[i] += velocities[i] * deltaTime;
+}
+
+// Entities with a box fall until something holds them
+void applyGravity(EntityStore& entities, float gravity, float maxFallSpeed, float deltaTime){
+    const Collider* colliders = entities.colliders.data();
+    glm::vec3* velocities = entities.velocities.data();
+    size_t count = entities.size();
+
+    for (size_t i = 0; i < count; i++){
+        if (colliders[i].halfExtents.y <= 0.0f) continue;
+
+        velocities[i].y = std::max(velocities[i].y - gravity * deltaTime, -maxFallSpeed);
+    }
+}
+
+// Like integrateVelocities(), but entities with a box sweep it through the
+// blocks, and lose the speed along the axes they hit.
+void moveEntities(EntityStore& entities, const VoxelGrid& voxels, float deltaTime){
+    glm::vec3* positions = entities.positions.data();
+    glm::vec3* velocities = entities.velocities.data();
+    const Collider* colliders = entities.colliders.data();
+    size_t count = entities.size();
+
+    for (size_t i = 0; i < count; i++){
+        glm::vec3 displacement = velocities[i] * deltaTime;
+        glm::vec3 extents = colliders[i].halfExtents;
+
+        if (extents.x <= 0.0f || extents.y <= 0.0f || extents.z <= 0.0f){
+            positions[i] += displacement;
+            continue;
+        }
+
+        Aabb box = {positions[i] - extents, positions[i] + extents};
+        SweepResult sweep = sweepAabb(voxels, box, displacement);
+
+        positions[i] += sweep.displacement;
+
+        for (int axis = 0; axis < 3; axis++){
+            if (sweep.hit[axis]) velocities[i][axis] = 0.0f;
+        }
+    }
+}
+
+// Removes whatever fell off the map
+void destroyEntitiesBelow(EntityStore& entities, float height){
+    for (size_t i = entities.size(); i-- > 0;){
+        if (entities.positions[i].y < height) entities.destroy(entities.getIds()[i]);
+    }
+}
@@ -0,0 +1,167 @@
+#include "generation_cache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include "terrain_generator.hpp"
+#include "world_storage.hpp"
+
+double GenerationCacheStats::getHitRate() const {
+    long lookups = this->hits + this->misses;
+
+    return lookups > 0 ? (double) this->hits / lookups : 0.0;
+}
+
+bool GenerationCache::Key::operator==(const Key& other) const {
+    return this->seed == other.seed && this->version == other.version && this->chunk == other.chunk;
+}
+
+size_t GenerationCache::KeyHash::operator()(const Key& key) const {
+    uint64_t hash = getChunkKey(key.chunk);
+
+    hash ^= ((uint64_t) key.seed << 1 | key.version) * 0x9e3779b97f4a7c15ull;
+
+    return hash ^ (hash >> 29);
+}
+
+GenerationCache::GenerationCache(size_t capacity, const char* spillDirectory){
+    this->capacity = capacity;
+
+    if (spillDirectory != NULL){
+        std::error_code error;
+        std::filesystem::create_directories(spillDirectory, error);
+
+        if (error) fprintf(stderr, "ERROR: Cannot create cache directory \"%s\".\n", spillDirectory);
+        else this->spillDirectory = spillDirectory;
+    }
+}
+
+GenerationCache::~GenerationCache(){
+    flush();
+}
+
+// Region file of the chunk, for its seed and version; NULL if there is none
+// and "create" is not set
+RegionFile* GenerationCache::getRegion(const Key& key, bool create){
+    if (this->spillDirectory.empty()) return NULL;
+
+    glm::ivec3 region = RegionFile::getRegionOf(key.chunk);
+
+    char name[96];
+    snprintf(name, sizeof(name), "/%u.v%d.r.%d.%d.%d.mglr", key.seed, key.version, region.x, region.y, region.z);
+    std::string filename = this->spillDirectory + name;
+
+    std::unique_ptr<RegionFile>& file = this->regions[filename];
+
+    if (file == NULL){
+        if (!create && !std::filesystem::exists(filename)) return NULL;
+
+        file.reset(new RegionFile());
+        if (!file->open(filename)) file.reset(new RegionFile());
+    }
+
+    return file->isOpen() ? file.get() : NULL;
+}
+
+bool GenerationCache::readSpilled(const Key& key, std::unique_ptr<Chunk>& blocks){
+    RegionFile* region = getRegion(key, false);
+    if (region == NULL) return false;
+
+    size_t length;
+    const uint8_t* payload = region->view(RegionFile::getLocalOf(key.chunk), length);
+
+    return payload != NULL && decodeChunk(payload, length, blocks);
+}
+
+// Chunks are only written once, generated chunks never change
+void GenerationCache::spill(Entry& entry){
+    if (entry.spilled) return;
+
+    RegionFile* region = getRegion(entry.key, true);
+    if (region == NULL) return;
+
+    std::vector<uint8_t> payload;
+    encodeChunk(entry.blocks.get(), payload);
+
+    if (region->write(RegionFile::getLocalOf(entry.key.chunk), payload)){
+        entry.spilled = true;
+        this->stats.spills++;
+    }
+}
+
+void GenerationCache::add(const Key& key, std::unique_ptr<Chunk> blocks, bool spilled){
+    size_t bytes = sizeof(Entry) + (blocks != NULL ? blocks->getMemoryUsage() : 0);
+
+    this->entries.push_front({key, std::move(blocks), bytes, spilled});
+    this->index[key] = this->entries.begin();
+    this->stats.bytes += bytes;
+    this->stats.entries++;
+
+    evict();
+}
+
+void GenerationCache::evict(){
+    while (this->stats.bytes > this->capacity && !this->entries.empty()){
+        Entry& entry = this->entries.back();
+
+        spill(entry);
+
+        this->stats.bytes -= entry.bytes;
+        this->stats.entries--;
+        this->stats.evictions++;
+
+        this->index.erase(entry.key);
+        this->entries.pop_back();
+    }
+}
+
+// A copy of the chunk, NULL if it is only air, in "blocks"; false if it
+// was never generated for this seed
+bool GenerationCache::find(unsigned int seed, glm::ivec3 chunk, std::unique_ptr<Chunk>& blocks){
+    Key key = {seed, TERRAIN_GENERATOR_VERSION, chunk};
+    auto found = this->index.find(key);
+
+    if (found != this->index.end()){
+        this->entries.splice(this->entries.begin(), this->entries, found->second);
+
+        const Chunk* cached = found->second->blocks.get();
+        blocks.reset(cached != NULL ? new Chunk(*cached) : NULL);
+
+        this->stats.hits++;
+        return true;
+    }
+
+    std::unique_ptr<Chunk> spilled;
+
+    if (readSpilled(key, spilled)){
+        blocks.reset(spilled != NULL ? new Chunk(*spilled) : NULL);
+        add(key, std::move(spilled), true);
+
+        this->stats.hits++;
+        this->stats.diskHits++;
+        return true;
+    }
+
+    this->stats.misses++;
+    return false;
+}
+
+// Keeps a copy of "blocks", NULL for a chunk of only air
+void GenerationCache::insert(unsigned int seed, glm::ivec3 chunk, const Chunk* blocks){
+    Key key = {seed, TERRAIN_GENERATOR_VERSION, chunk};
+    if (this->index.count(key)) return;
+
+    add(key, std::unique_ptr<Chunk>(blocks != NULL ? new Chunk(*blocks) : NULL), false);
+}
+
+// Writes every chunk still only in memory to the spill directory, if any
+void GenerationCache::flush(){
+    if (this->spillDirectory.empty()) return;
+
+    for (Entry& entry : this->entries) spill(entry);
+}
+
+const GenerationCacheStats& GenerationCache::getStats(){
+    return this->stats;
+}
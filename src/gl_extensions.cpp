@@ -0,0 +1,58 @@
+#include <cstring>
+
+#include "gl_extensions.hpp"
+
+int GLEXT_ARB_get_program_binary = 0;
+int GLEXT_ARB_buffer_storage = 0;
+int GLEXT_ARB_multi_draw_indirect = 0;
+
+PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYPROC glext_glProgramBinary = NULL;
+PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri = NULL;
+PFNGLBUFFERSTORAGEPROC glext_glBufferStorage = NULL;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect = NULL;
+
+static bool versionAtLeast(int major, int minor){
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+static bool hasExtension(const char* name){
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (GLint i = 0; i < count; i++){
+        const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+
+        if (extension != NULL && strcmp(extension, name) == 0) return true;
+    }
+
+    return false;
+}
+
+void loadGlExtensions(GLADloadproc load){
+    if (versionAtLeast(4, 1) || hasExtension("GL_ARB_get_program_binary")){
+        glext_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC) load("glGetProgramBinary");
+        glext_glProgramBinary = (PFNGLPROGRAMBINARYPROC) load("glProgramBinary");
+        glext_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC) load("glProgramParameteri");
+
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+        GLEXT_ARB_get_program_binary = glext_glGetProgramBinary != NULL && glext_glProgramBinary != NULL &&
+                                       glext_glProgramParameteri != NULL && formats > 0;
+    }
+
+    if (versionAtLeast(4, 4) || hasExtension("GL_ARB_buffer_storage")){
+        glext_glBufferStorage = (PFNGLBUFFERSTORAGEPROC) load("glBufferStorage");
+
+        GLEXT_ARB_buffer_storage = glext_glBufferStorage != NULL;
+    }
+
+    // The indirect buffer binding comes from ARB_draw_indirect (OpenGL 4.0)
+    if (versionAtLeast(4, 3) ||
+        (hasExtension("GL_ARB_multi_draw_indirect") && hasExtension("GL_ARB_draw_indirect"))){
+        glext_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC) load("glMultiDrawElementsIndirect");
+
+        GLEXT_ARB_multi_draw_indirect = glext_glMultiDrawElementsIndirect != NULL;
+    }
+}
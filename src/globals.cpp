@@ -15,14 +15,11 @@ bool g_LeftMouseButtonPressed = false;
 double g_LastCursorPosX = 0.0f;
 double g_LastCursorPosY = 0.0f;
 
-double deltaTime = 0.0f;
-
 glm::vec4 camera_position_free = glm::vec4(-1.0f, 1.0f, 5.0f, 1.0f);
 glm::vec4 camera_position_look = glm::vec4(0.0f, 0.0f, 2.5f, 1.0f);
 glm::vec4 camera_view_free = glm::vec4(0.0f, 0.0f, 2.5f, 1.0f);
 glm::vec4 camera_view_look = glm::vec4(0.0f, 0.0f, 2.5f, 1.0f);
 
 Camera camera = Camera(10.0f, 2.5f, camera_position_free, camera_position_look, camera_view_free, camera_view_look);
+CommandQueue inputCommands;
 glm::vec4 mapData[MAP_SIZE][MAP_SIZE] = {glm::vec4(0.0f, 0.0f, 0.0f, 0.0f)};
-glm::vec3 cowPosition = glm::vec3(0.0f, 0.0f, 0.0f);
-glm::vec3 cowRotate = glm::vec3(0.0f,0.0f,0.0f);
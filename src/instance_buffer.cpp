@@ -0,0 +1,41 @@
+#include "instance_buffer.hpp"
+
+#include <algorithm>
+
+// "capacity" is the number of matrices one frame can upload
+InstanceBuffer::InstanceBuffer(size_t capacity) : stream(capacity * sizeof(glm::mat4)){
+}
+
+// Copies as many of "models" as still fit in this frame's section and sets
+// "offset" to the byte offset they were written at. Returns how many were
+// copied, 0 once the section is full.
+size_t InstanceBuffer::upload(const glm::mat4* models, size_t count, GLintptr& offset){
+    size_t fitting = std::min(count, this->stream.getRemaining(sizeof(glm::mat4)) / sizeof(glm::mat4));
+
+    if (fitting == 0 || !this->stream.write(models, fitting * sizeof(glm::mat4), sizeof(glm::mat4), offset)) return 0;
+
+    return fitting;
+}
+
+// Points the mat4 attribute at "location" (using four consecutive locations)
+// of the bound vertex array to the matrices uploaded at "offset", advancing
+// once per instance.
+void InstanceBuffer::bindAttributes(GLuint location, GLintptr offset){
+    glBindBuffer(GL_ARRAY_BUFFER, this->stream.getId());
+
+    for (GLuint column = 0; column < 4; column++){
+        glVertexAttribPointer(location + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*) (offset + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location + column, 1);
+        glEnableVertexAttribArray(location + column);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::endFrame(){
+    this->stream.endFrame();
+}
+
+bool InstanceBuffer::isPersistent(){
+    return this->stream.isPersistent();
+}
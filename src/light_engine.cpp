@@ -0,0 +1,299 @@
+#include "light_engine.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static const glm::ivec3 neighbourOffsets[6] = {
+    glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0),
+    glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0),
+    glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1)
+};
+
+static uint64_t blockKey(glm::ivec3 block){
+    const uint64_t mask = (1 << 21) - 1;
+
+    return ((uint64_t) block.x & mask) | (((uint64_t) block.y & mask) << 21) | (((uint64_t) block.z & mask) << 42);
+}
+
+static inline int levelOf(uint8_t cell, LightChannel channel){
+    return channel == skyLight ? cell >> 4 : cell & 0x0f;
+}
+
+LightEngine::LightEngine(VoxelGrid& voxels) : voxels(voxels){
+    this->origin = voxels.getOrigin();
+    this->size = voxels.getSize();
+    this->chunkOrigin = getChunkOf(this->origin);
+    this->chunkCounts = this->size / CHUNK_SIZE;
+
+    size_t count = (size_t) this->chunkCounts.x * this->chunkCounts.y * this->chunkCounts.z;
+    this->chunks.resize(count);
+
+    for (std::unique_ptr<uint8_t[]>& chunk : this->chunks) {
+        chunk.reset(new uint8_t[CHUNK_VOLUME]);
+        memset(chunk.get(), 0, CHUNK_VOLUME);
+    }
+}
+
+// NULL outside of the grid
+uint8_t* LightEngine::getCell(glm::ivec3 block) const {
+    glm::ivec3 local = block - this->origin;
+
+    if (local.x < 0 || local.x >= this->size.x || local.y < 0 || local.y >= this->size.y ||
+        local.z < 0 || local.z >= this->size.z) return NULL;
+
+    glm::ivec3 chunk = getChunkOf(block) - this->chunkOrigin;
+    size_t index = ((size_t) chunk.x * this->chunkCounts.z + chunk.z) * this->chunkCounts.y + chunk.y;
+
+    return &this->chunks[index][Chunk::indexOf(getLocalOf(block))];
+}
+
+// Light the block gives off by itself: the sky shines into the air of the
+// top layer, sources into the air they are in
+int LightEngine::getEmission(LightChannel channel, glm::ivec3 block) const {
+    if (this->voxels.isSolid(block)) return 0;
+
+    if (channel == skyLight) return block.y == this->origin.y + this->size.y - 1 ? MAX_LIGHT : 0;
+
+    auto source = this->sources.find(blockKey(block));
+
+    return source != this->sources.end() ? source->second.level : 0;
+}
+
+void LightEngine::setLight(LightChannel channel, glm::ivec3 block, int level){
+    uint8_t* cell = getCell(block);
+    if (cell == NULL) return;
+
+    if (channel == skyLight) *cell = (uint8_t) ((level << 4) | (*cell & 0x0f));
+    else *cell = (uint8_t) ((*cell & 0xf0) | level);
+
+    this->voxels.markDirtyAround(block, block);
+}
+
+// Darkens the blocks lit through the queued ones; neighbours brighter than
+// what was removed have their own light, which is spread back afterwards
+void LightEngine::spreadRemovals(LightChannel channel){
+    std::vector<LightNode>& queue = this->removeQueues[channel];
+    std::vector<LightNode>& additions = this->addQueues[channel];
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        LightNode node = queue[head];
+
+        for (const glm::ivec3& offset : neighbourOffsets) {
+            glm::ivec3 neighbour = node.block + offset;
+            const uint8_t* cell = getCell(neighbour);
+            if (cell == NULL) continue;
+
+            int level = levelOf(*cell, channel);
+            if (level == 0) continue;
+
+            bool fromAbove = channel == skyLight && offset.y == -1 && node.level == MAX_LIGHT;
+
+            if (level < node.level || (fromAbove && level == MAX_LIGHT)) {
+                setLight(channel, neighbour, 0);
+                queue.push_back({neighbour, level});
+                this->stats.removed++;
+
+                int emission = getEmission(channel, neighbour);
+
+                if (emission > 0) {
+                    setLight(channel, neighbour, emission);
+                    additions.push_back({neighbour, emission});
+                }
+            } else {
+                additions.push_back({neighbour, level});
+            }
+        }
+    }
+
+    queue.clear();
+}
+
+void LightEngine::spreadAdditions(LightChannel channel){
+    std::vector<LightNode>& queue = this->addQueues[channel];
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        glm::ivec3 block = queue[head].block;
+
+        // The block may have been darkened since it was queued
+        int level = getLight(channel, block);
+        if (level <= 1) continue;
+
+        for (const glm::ivec3& offset : neighbourOffsets) {
+            glm::ivec3 neighbour = block + offset;
+            const uint8_t* cell = getCell(neighbour);
+            if (cell == NULL || this->voxels.isSolid(neighbour)) continue;
+
+            int spread = channel == skyLight && offset.y == -1 && level == MAX_LIGHT ? MAX_LIGHT : level - 1;
+
+            if (spread > levelOf(*cell, channel)) {
+                setLight(channel, neighbour, spread);
+                queue.push_back({neighbour, spread});
+                this->stats.added++;
+            }
+        }
+    }
+
+    queue.clear();
+}
+
+int LightEngine::getLight(LightChannel channel, glm::ivec3 block) const {
+    const uint8_t* cell = getCell(block);
+
+    if (cell == NULL) return channel == skyLight ? MAX_LIGHT : 0;
+
+    return levelOf(*cell, channel);
+}
+
+// The light of a chunk, in the order of Chunk::indexOf(); NULL outside of
+// the grid
+const uint8_t* LightEngine::getChunkLight(glm::ivec3 chunk) const {
+    glm::ivec3 local = chunk - this->chunkOrigin;
+
+    if (local.x < 0 || local.x >= this->chunkCounts.x || local.y < 0 || local.y >= this->chunkCounts.y ||
+        local.z < 0 || local.z >= this->chunkCounts.z) return NULL;
+
+    return this->chunks[((size_t) local.x * this->chunkCounts.z + local.z) * this->chunkCounts.y + local.y].get();
+}
+
+// Lights the whole grid from scratch, from the sky and every source
+void LightEngine::relightAll(){
+    for (std::unique_ptr<uint8_t[]>& chunk : this->chunks) memset(chunk.get(), 0, CHUNK_VOLUME);
+
+    glm::ivec3 block;
+    block.y = this->origin.y + this->size.y - 1;
+
+    for (block.z = this->origin.z; block.z < this->origin.z + this->size.z; block.z++) {
+        for (block.x = this->origin.x; block.x < this->origin.x + this->size.x; block.x++) {
+            if (this->voxels.isSolid(block)) continue;
+
+            setLight(skyLight, block, MAX_LIGHT);
+            this->addQueues[skyLight].push_back({block, MAX_LIGHT});
+        }
+    }
+
+    for (const auto& source : this->sources) {
+        const LightNode& node = source.second;
+        if (getEmission(blockLight, node.block) == 0) continue;
+
+        setLight(blockLight, node.block, node.level);
+        this->addQueues[blockLight].push_back(node);
+    }
+
+    propagate();
+}
+
+// To call after the block changed in the grid
+void LightEngine::blockChanged(glm::ivec3 block){
+    bool solid = this->voxels.isSolid(block);
+
+    for (int c = 0; c < LIGHT_CHANNELS; c++) {
+        LightChannel channel = (LightChannel) c;
+        int level = getLight(channel, block);
+
+        if (solid) {
+            if (level == 0) continue;
+
+            setLight(channel, block, 0);
+            this->removeQueues[channel].push_back({block, level});
+            continue;
+        }
+
+        int emission = getEmission(channel, block);
+
+        if (emission > level) {
+            setLight(channel, block, emission);
+            this->addQueues[channel].push_back({block, emission});
+        }
+
+        // The light around now spreads through the block
+        for (const glm::ivec3& offset : neighbourOffsets) {
+            const uint8_t* cell = getCell(block + offset);
+            if (cell != NULL && levelOf(*cell, channel) > 0) this->addQueues[channel].push_back({block + offset, levelOf(*cell, channel)});
+        }
+    }
+}
+
+// To call after all the blocks of the chunk changed at once: its light is
+// removed, then lit back from its sources and from the blocks around it
+void LightEngine::chunkReplaced(glm::ivec3 chunk){
+    glm::ivec3 base = chunk * CHUNK_SIZE;
+    glm::ivec3 local;
+
+    for (local.y = 0; local.y < CHUNK_SIZE; local.y++) {
+        for (local.z = 0; local.z < CHUNK_SIZE; local.z++) {
+            for (local.x = 0; local.x < CHUNK_SIZE; local.x++) {
+                glm::ivec3 block = base + local;
+                bool border = glm::any(glm::equal(local, glm::ivec3(0))) || glm::any(glm::equal(local, glm::ivec3(CHUNK_SIZE - 1)));
+
+                for (int c = 0; c < LIGHT_CHANNELS; c++) {
+                    LightChannel channel = (LightChannel) c;
+                    int level = getLight(channel, block);
+
+                    if (level > 0) {
+                        setLight(channel, block, 0);
+                        this->removeQueues[channel].push_back({block, level});
+                    }
+
+                    int emission = getEmission(channel, block);
+
+                    if (emission > 0) {
+                        setLight(channel, block, emission);
+                        this->addQueues[channel].push_back({block, emission});
+                    }
+
+                    if (!border) continue;
+
+                    // Blocks that used to be solid get no removal, the light
+                    // around the chunk is spread into it anyway
+                    for (const glm::ivec3& offset : neighbourOffsets) {
+                        glm::ivec3 neighbour = block + offset;
+                        const uint8_t* cell = getCell(neighbour);
+                        if (cell == NULL || getChunkOf(neighbour) == chunk) continue;
+
+                        if (levelOf(*cell, channel) > 0) this->addQueues[channel].push_back({neighbour, levelOf(*cell, channel)});
+                    }
+                }
+            }
+        }
+    }
+}
+
+// A light source of "level" in the block, such as a torch. Sources only
+// shine while their block is air.
+void LightEngine::addSource(glm::ivec3 block, int level){
+    level = std::min(level, MAX_LIGHT);
+    this->sources[blockKey(block)] = {block, level};
+
+    if (getEmission(blockLight, block) > getLight(blockLight, block)) {
+        setLight(blockLight, block, level);
+        this->addQueues[blockLight].push_back({block, level});
+    }
+}
+
+void LightEngine::removeSource(glm::ivec3 block){
+    if (this->sources.erase(blockKey(block)) == 0) return;
+
+    int level = getLight(blockLight, block);
+    if (level == 0) return;
+
+    setLight(blockLight, block, 0);
+    this->removeQueues[blockLight].push_back({block, level});
+}
+
+bool LightEngine::isSource(glm::ivec3 block) const {
+    return this->sources.count(blockKey(block)) > 0;
+}
+
+// Spreads every queued change
+void LightEngine::propagate(){
+    this->stats = LightStats();
+
+    for (int channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        spreadRemovals((LightChannel) channel);
+        spreadAdditions((LightChannel) channel);
+    }
+}
+
+const LightStats& LightEngine::getStats() const {
+    return this->stats;
+}
@@ -237,4 +237,33 @@ void ObjModel::DrawVirtualObject(const char* object_name){
     // "Desligamos" o VAO, evitando assim que operações posteriores venham a
     // alterar o mesmo. Isso evita bugs.
     glBindVertexArray(0);
-}
\ No newline at end of file
+}
+
+// Draws one copy of an object of g_VirtualScene per matrix in "models" with a
+// single call. The matrices go through "instances" and are read by the
+// "(location = 3)" attribute of "shader_vertex.glsl". Returns how many copies
+// fit in the buffer and were drawn.
+size_t ObjModel::DrawVirtualObjectInstanced(const char* object_name, InstanceBuffer& instances, const glm::mat4* models, size_t count){
+    SceneObject& object = g_VirtualScene[object_name];
+
+    GLintptr offset = 0;
+    size_t uploaded = instances.upload(models, count, offset);
+
+    if (uploaded == 0) return 0;
+
+    glBindVertexArray(object.id);
+
+    instances.bindAttributes(3, offset);
+
+    glDrawElementsInstanced(
+        object.renderingMode,
+        object.numIndexes,
+        GL_UNSIGNED_INT,
+        (void*)(object.firstIndex * sizeof(GLuint)),
+        uploaded
+    );
+
+    glBindVertexArray(0);
+
+    return uploaded;
+}
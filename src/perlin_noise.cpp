@@ -1,20 +1,20 @@
 #include "perlin_noise.hpp"
 
 #include <cstdlib>
-#include <time.h>
 #include <cmath>
 #include <cstdio>
 
-PerlinNoise::PerlinNoise(int row, int col){
+PerlinNoise::PerlinNoise(int row, int col, unsigned int randomSeed){
     this->row = row;
     this->col = col;
+    this->randomSeed = randomSeed;
 }
 
 void PerlinNoise::generateSeed(){
     int row = this->row;
     int col = this->col;
 
-    srand(time(NULL));
+    srand(this->randomSeed);
 
     float seedPoint;
 
@@ -0,0 +1,219 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+SampleWindow::SampleWindow(size_t capacity){
+    this->samples.resize(capacity);
+}
+
+void SampleWindow::add(double sample){
+    this->samples[this->next] = sample;
+    this->next = (this->next + 1) % this->samples.size();
+    this->count = min(this->count + 1, this->samples.size());
+}
+
+double SampleWindow::percentile(double p) const {
+    if (this->count == 0) return 0.0;
+
+    vector<double> sorted(this->samples.begin(), this->samples.begin() + this->count);
+
+    size_t rank = (size_t) (p / 100.0 * (this->count - 1) + 0.5);
+    nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+
+    return sorted[rank];
+}
+
+size_t SampleWindow::size() const {
+    return this->count;
+}
+
+// "frameName" labels the unit timed by beginFrame() and endFrame() in the
+// reports, e.g. "tick" for a simulation loop.
+Profiler::Profiler(const char* frameName){
+    this->frameName = frameName;
+    this->origin = Clock::now();
+    this->frameStart = this->origin;
+}
+
+int Profiler::addPhase(const char* name, bool gpu){
+    Phase phase;
+    phase.name = name;
+    phase.gpu = gpu;
+
+    for (int i = 0; i < QUERY_BUFFERS; i++){
+        phase.queries[i] = 0;
+        phase.pending[i] = false;
+    }
+
+    if (gpu) glGenQueries(QUERY_BUFFERS, phase.queries);
+
+    this->phases.push_back(phase);
+
+    return (int) this->phases.size() - 1;
+}
+
+void Profiler::enableTrace(const char* filename){
+    this->traceFilename = filename;
+    this->trace.reserve(1 << 16);
+}
+
+double Profiler::toMicroseconds(Clock::time_point time){
+    return chrono::duration<double, micro>(time - this->origin).count();
+}
+
+// Reads back the GPU queries of one buffer if the results are ready
+void Profiler::collectQueries(int buffer){
+    for (size_t i = 0; i < this->phases.size(); i++){
+        Phase& phase = this->phases[i];
+
+        if (!phase.gpu || !phase.pending[buffer]) continue;
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(phase.queries[buffer], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (!available) continue;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(phase.queries[buffer], GL_QUERY_RESULT, &elapsed);
+        phase.pending[buffer] = false;
+
+        double milliseconds = elapsed / 1.0e6;
+        phase.gpuTimes.add(milliseconds);
+
+        if (!this->traceFilename.empty() && this->trace.size() < MAX_TRACE_EVENTS){
+            this->trace.push_back({(int) i, true, toMicroseconds(this->queryFrameStarts[buffer]), milliseconds * 1000.0});
+        }
+    }
+}
+
+void Profiler::beginFrame(){
+    int buffer = this->frame % QUERY_BUFFERS;
+
+    collectQueries(buffer);
+
+    this->frameStart = Clock::now();
+    this->queryFrameStarts[buffer] = this->frameStart;
+}
+
+void Profiler::endFrame(){
+    Clock::time_point now = Clock::now();
+
+    this->frames.add(chrono::duration<double, milli>(now - this->frameStart).count());
+    this->frame++;
+}
+
+void Profiler::begin(int phase){
+    Phase& current = this->phases[phase];
+    int buffer = this->frame % QUERY_BUFFERS;
+
+    // A query still in flight from two frames ago cannot be reused yet
+    if (current.gpu && !current.pending[buffer]) glBeginQuery(GL_TIME_ELAPSED, current.queries[buffer]);
+
+    current.start = Clock::now();
+}
+
+void Profiler::end(int phase){
+    Clock::time_point now = Clock::now();
+
+    Phase& current = this->phases[phase];
+    int buffer = this->frame % QUERY_BUFFERS;
+
+    if (current.gpu && !current.pending[buffer]){
+        glEndQuery(GL_TIME_ELAPSED);
+        current.pending[buffer] = true;
+    }
+
+    double milliseconds = chrono::duration<double, milli>(now - current.start).count();
+    current.cpuTimes.add(milliseconds);
+
+    if (!this->traceFilename.empty() && this->trace.size() < MAX_TRACE_EVENTS){
+        this->trace.push_back({phase, false, toMicroseconds(current.start), milliseconds * 1000.0});
+    }
+}
+
+void Profiler::report(){
+    printf("%-10s %8.3f ms p50 %8.3f ms p95 %8.3f ms p99\n", this->frameName.c_str(),
+           this->frames.percentile(50), this->frames.percentile(95), this->frames.percentile(99));
+
+    for (const Phase& phase : this->phases){
+        printf("  %-14s cpu %7.3f / %7.3f / %7.3f ms", phase.name.c_str(),
+               phase.cpuTimes.percentile(50), phase.cpuTimes.percentile(95), phase.cpuTimes.percentile(99));
+
+        if (phase.gpu && phase.gpuTimes.size() > 0){
+            printf("   gpu %7.3f / %7.3f / %7.3f ms",
+                   phase.gpuTimes.percentile(50), phase.gpuTimes.percentile(95), phase.gpuTimes.percentile(99));
+        }
+
+        printf("\n");
+    }
+}
+
+// Same statistics as report(), as a JSON object with times in milliseconds
+void Profiler::reportJson(FILE* file){
+    fprintf(file, "{\"frame\":{\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f}",
+            this->frames.percentile(50), this->frames.percentile(95), this->frames.percentile(99));
+
+    for (const Phase& phase : this->phases){
+        fprintf(file, ",\"%s\":{\"cpu\":{\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f}", phase.name.c_str(),
+                phase.cpuTimes.percentile(50), phase.cpuTimes.percentile(95), phase.cpuTimes.percentile(99));
+
+        if (phase.gpu && phase.gpuTimes.size() > 0){
+            fprintf(file, ",\"gpu\":{\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f}",
+                    phase.gpuTimes.percentile(50), phase.gpuTimes.percentile(95), phase.gpuTimes.percentile(99));
+        }
+
+        fprintf(file, "}");
+    }
+
+    fprintf(file, "}");
+}
+
+// Writes the recorded events in the Chrome trace event format, which can be
+// opened in chrome://tracing or Perfetto. CPU phases are complete events on
+// one track; GPU durations are counters, since GL_TIME_ELAPSED carries no
+// start time.
+bool Profiler::writeTrace(){
+    if (this->traceFilename.empty()) return false;
+
+    FILE* file = fopen(this->traceFilename.c_str(), "w");
+
+    if (file == NULL){
+        fprintf(stderr, "ERROR: Cannot open file \"%s\".\n", this->traceFilename.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+
+    for (size_t i = 0; i < this->trace.size(); i++){
+        const TraceEvent& event = this->trace[i];
+        const char* name = this->phases[event.phase].name.c_str();
+
+        if (event.gpu){
+            fprintf(file, "{\"name\":\"gpu %s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":2,\"args\":{\"ms\":%.4f}}",
+                    name, event.timestamp, event.duration / 1000.0);
+        }else{
+            fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+                    name, event.timestamp, event.duration);
+        }
+
+        fprintf(file, i + 1 < this->trace.size() ? ",\n" : "\n");
+    }
+
+    fprintf(file, "]}\n");
+    fclose(file);
+
+    printf("Trace with %zu events written to \"%s\"\n", this->trace.size(), this->traceFilename.c_str());
+
+    return true;
+}
+
+ScopedTimer::ScopedTimer(Profiler& profiler, int phase) : profiler(profiler), phase(phase){
+    this->profiler.begin(phase);
+}
+
+ScopedTimer::~ScopedTimer(){
+    this->profiler.end(this->phase);
+}
@@ -1,27 +1,22 @@
 #include <string>
 
 #include "program.hpp"
+#include "gl_extensions.hpp"
 
 GLuint Program::getId(){
     return this->id;
 }
 
-void Program::createGpuProgram(GLuint vertexShader, GLuint fragmentShader){
-    this->id = glCreateProgram();
-
-    glAttachShader(this->id, vertexShader);
-    glAttachShader(this->id, fragmentShader);
-
-    glLinkProgram(this->id);
-
+bool Program::checkLinkStatus(bool reportErrors){
     GLint linked = GL_FALSE;
     glGetProgramiv(this->id, GL_LINK_STATUS, &linked);
 
-    if (linked == GL_FALSE){
+    if (linked == GL_FALSE && reportErrors){
         GLint logLenght = 0;
         glGetProgramiv(this->id, GL_INFO_LOG_LENGTH, &logLenght);
 
-        GLchar* log = new GLchar[logLenght];
+        GLchar* log = new GLchar[logLenght + 1];
+        log[0] = '\0';
 
         glGetProgramInfoLog(this->id, logLenght, &logLenght, log);
 
@@ -36,4 +31,54 @@ void Program::createGpuProgram(GLuint vertexShader, GLuint fragmentShader){
 
         fprintf(stderr, "%s", output.c_str());
     }
-}
\ No newline at end of file
+
+    return linked == GL_TRUE;
+}
+
+bool Program::createGpuProgram(GLuint vertexShader, GLuint fragmentShader){
+    this->id = glCreateProgram();
+
+    glAttachShader(this->id, vertexShader);
+    glAttachShader(this->id, fragmentShader);
+
+    // Asks the driver to keep the linked binary around so it can be cached
+    if (GLEXT_ARB_get_program_binary) glProgramParameteri(this->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    glLinkProgram(this->id);
+
+    return checkLinkStatus(true);
+}
+
+// A binary is rejected (without any error being reported) whenever the driver
+// changed since it was produced, so the caller must be ready to compile again.
+bool Program::createGpuProgramFromBinary(GLenum binaryFormat, const std::vector<char>& binary){
+    if (!GLEXT_ARB_get_program_binary || binary.empty()) return false;
+
+    this->id = glCreateProgram();
+
+    glProgramBinary(this->id, binaryFormat, binary.data(), (GLsizei) binary.size());
+
+    if (!checkLinkStatus(false)){
+        glDeleteProgram(this->id);
+        this->id = 0;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool Program::getBinary(GLenum& binaryFormat, std::vector<char>& binary){
+    if (!GLEXT_ARB_get_program_binary || this->id == 0) return false;
+
+    GLint length = 0;
+    glGetProgramiv(this->id, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0) return false;
+
+    binary.resize(length);
+    glGetProgramBinary(this->id, length, &length, &binaryFormat, binary.data());
+    binary.resize(length);
+
+    return length > 0;
+}
@@ -0,0 +1,253 @@
+#include "region_file.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chunk.hpp"
+
+static const char regionMagic[4] = {'M', 'G', 'L', 'R'};
+
+// Version 2 stores palette chunks, see Chunk::serialize()
+static const uint32_t REGION_VERSION = 2;
+
+// Magic, version, region size and a reserved word, then the table
+#define HEADER_SIZE 16
+#define TABLE_SIZE (REGION_VOLUME * 8)
+
+// First sector after the header and the table
+#define DATA_SECTOR ((HEADER_SIZE + TABLE_SIZE + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE)
+
+static void put32(uint8_t* data, uint32_t value){
+    data[0] = value & 0xff;
+    data[1] = (value >> 8) & 0xff;
+    data[2] = (value >> 16) & 0xff;
+    data[3] = (value >> 24) & 0xff;
+}
+
+static uint32_t get32(const uint8_t* data){
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static uint32_t sectorsFor(uint32_t length){
+    return (length + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+}
+
+// Whole buffer at "offset", retrying short writes
+static bool writeAt(int descriptor, const uint8_t* data, size_t size, off_t offset){
+    while (size > 0){
+        ssize_t written = pwrite(descriptor, data, size, offset);
+        if (written <= 0) return false;
+
+        data += written;
+        size -= written;
+        offset += written;
+    }
+
+    return true;
+}
+
+RegionFile::~RegionFile(){
+    if (this->mapping != NULL) munmap((void*) this->mapping, this->mappedSize);
+    if (this->descriptor >= 0) close(this->descriptor);
+}
+
+int RegionFile::indexOf(glm::ivec3 local){
+    return (local.y * REGION_SIZE + local.z) * REGION_SIZE + local.x;
+}
+
+// Maps the whole file, which always ends on a sector boundary. Chunks are
+// read in no particular order, so the kernel is told not to read around
+// the pages touched.
+bool RegionFile::map(){
+    size_t size = (size_t) this->sectorCount * REGION_SECTOR_SIZE;
+
+    if (this->mapping != NULL) munmap((void*) this->mapping, this->mappedSize);
+    this->mapping = NULL;
+    this->mappedSize = 0;
+
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, this->descriptor, 0);
+
+    if (mapping == MAP_FAILED){
+        fprintf(stderr, "ERROR: Cannot map region file \"%s\".\n", this->filename.c_str());
+        return false;
+    }
+
+    posix_madvise(mapping, size, POSIX_MADV_RANDOM);
+
+    this->mapping = (const uint8_t*) mapping;
+    this->mappedSize = size;
+
+    return true;
+}
+
+// Opens the file, creating an empty region if it does not exist yet
+bool RegionFile::open(const std::string& filename){
+    this->filename = filename;
+    this->descriptor = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+
+    struct stat status;
+
+    if (this->descriptor < 0 || fstat(this->descriptor, &status) != 0){
+        fprintf(stderr, "ERROR: Cannot open region file \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    if (status.st_size == 0){
+        std::vector<uint8_t> header((size_t) DATA_SECTOR * REGION_SECTOR_SIZE, 0);
+
+        memcpy(header.data(), regionMagic, 4);
+        put32(&header[4], REGION_VERSION);
+        put32(&header[8], REGION_SIZE);
+
+        if (!writeAt(this->descriptor, header.data(), header.size(), 0)){
+            fprintf(stderr, "ERROR: Cannot write region file \"%s\".\n", filename.c_str());
+            return false;
+        }
+
+        status.st_size = header.size();
+    }
+
+    this->sectorCount = status.st_size / REGION_SECTOR_SIZE;
+
+    if (this->sectorCount < DATA_SECTOR || !map() ||
+        memcmp(this->mapping, regionMagic, 4) != 0 || get32(this->mapping + 4) != REGION_VERSION ||
+        get32(this->mapping + 8) != REGION_SIZE){
+        fprintf(stderr, "ERROR: \"%s\" is not a region file of this version.\n", filename.c_str());
+        return false;
+    }
+
+    for (int i = 0; i < REGION_VOLUME; i++){
+        const uint8_t* entry = this->mapping + HEADER_SIZE + i * 8;
+
+        this->table[i].sector = get32(entry);
+        this->table[i].length = get32(entry + 4);
+
+        // Touching the mapping past the end of the file would crash
+        if (this->table[i].sector != 0 &&
+            (this->table[i].sector < DATA_SECTOR ||
+             (uint64_t) this->table[i].sector + sectorsFor(this->table[i].length) > this->sectorCount)){
+            fprintf(stderr, "ERROR: Region file \"%s\" has a chunk out of the file.\n", filename.c_str());
+            this->table[i] = {0, 0};
+        }
+    }
+
+    this->usedSectors.assign(this->sectorCount, false);
+
+    for (int i = 0; i < REGION_VOLUME; i++){
+        if (this->table[i].sector != 0) markSectors(this->table[i], true);
+    }
+
+    return true;
+}
+
+void RegionFile::markSectors(const Entry& entry, bool used){
+    uint32_t end = entry.sector + sectorsFor(entry.length);
+
+    for (uint32_t sector = entry.sector; sector < end; sector++) this->usedSectors[sector] = used;
+}
+
+// First sector of the first run of "sectors" free sectors, past the end of
+// the file when there is none
+uint32_t RegionFile::findFreeSectors(uint32_t sectors){
+    uint32_t run = 0;
+
+    for (uint32_t sector = DATA_SECTOR; sector < this->sectorCount; sector++){
+        run = this->usedSectors[sector] ? 0 : run + 1;
+
+        if (run == sectors) return sector + 1 - sectors;
+    }
+
+    return this->sectorCount;
+}
+
+bool RegionFile::isOpen(){
+    return this->mapping != NULL;
+}
+
+bool RegionFile::has(glm::ivec3 local){
+    return this->mapping != NULL && this->table[indexOf(local)].sector != 0;
+}
+
+// The payload of a chunk, inside the mapping: valid until the next write.
+// NULL if the chunk was never written.
+const uint8_t* RegionFile::view(glm::ivec3 local, size_t& length){
+    if (!has(local)) return NULL;
+
+    const Entry& entry = this->table[indexOf(local)];
+
+    // Written after the file was last mapped
+    if ((size_t) (entry.sector + sectorsFor(entry.length)) * REGION_SECTOR_SIZE > this->mappedSize && !map()){
+        return NULL;
+    }
+
+    length = entry.length;
+
+    return this->mapping + (size_t) entry.sector * REGION_SECTOR_SIZE;
+}
+
+// Hints that the chunk is about to be read, so its pages are read from disk
+// in the background
+void RegionFile::advise(glm::ivec3 local){
+    if (!has(local)) return;
+
+    const Entry& entry = this->table[indexOf(local)];
+    size_t end = (size_t) (entry.sector + sectorsFor(entry.length)) * REGION_SECTOR_SIZE;
+
+    if (end <= this->mappedSize){
+        posix_madvise((void*) (this->mapping + (size_t) entry.sector * REGION_SECTOR_SIZE),
+                      sectorsFor(entry.length) * REGION_SECTOR_SIZE, POSIX_MADV_WILLNEED);
+    }
+}
+
+// Writes go through the file descriptor, which shares the page cache with
+// the mapping. The payload goes to free sectors, never over the previous
+// one, and the table entry is only updated once it is written.
+bool RegionFile::write(glm::ivec3 local, const std::vector<uint8_t>& payload){
+    if (this->mapping == NULL || payload.empty()) return false;
+
+    Entry& entry = this->table[indexOf(local)];
+    uint32_t sectors = sectorsFor(payload.size());
+    uint32_t sector = findFreeSectors(sectors);
+    uint32_t sectorCount = std::max(this->sectorCount, sector + sectors);
+
+    // Padded to whole sectors, so the file always ends on a sector boundary
+    std::vector<uint8_t> padded(payload);
+    padded.resize((size_t) sectors * REGION_SECTOR_SIZE, 0);
+
+    uint8_t encoded[8];
+    put32(encoded, sector);
+    put32(encoded + 4, payload.size());
+
+    bool written = writeAt(this->descriptor, padded.data(), padded.size(), (off_t) sector * REGION_SECTOR_SIZE) &&
+                   writeAt(this->descriptor, encoded, 8, HEADER_SIZE + indexOf(local) * 8);
+
+    if (!written){
+        fprintf(stderr, "ERROR: Cannot write a chunk to region file \"%s\".\n", this->filename.c_str());
+        return false;
+    }
+
+    this->sectorCount = sectorCount;
+    this->usedSectors.resize(sectorCount, false);
+
+    if (entry.sector != 0) markSectors(entry, false);
+
+    entry.sector = sector;
+    entry.length = payload.size();
+    markSectors(entry, true);
+
+    return true;
+}
+
+glm::ivec3 RegionFile::getRegionOf(glm::ivec3 chunk){
+    return glm::ivec3(floorDivide(chunk.x, REGION_SIZE), floorDivide(chunk.y, REGION_SIZE), floorDivide(chunk.z, REGION_SIZE));
+}
+
+glm::ivec3 RegionFile::getLocalOf(glm::ivec3 chunk){
+    return chunk - getRegionOf(chunk) * REGION_SIZE;
+}
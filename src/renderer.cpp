@@ -0,0 +1,191 @@
+#include "renderer.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "globals.hpp"
+#include "std/matrices.h"
+
+#define COW 4
+#define LEAF 5
+
+// Most entities drawn per frame, all meshes together
+#define MAX_INSTANCES 32768
+
+static ProgramUniforms getProgramUniforms(GLuint programId) {
+    ProgramUniforms uniforms;
+
+    uniforms.model = glGetUniformLocation(programId, "model"); // Variável da matriz "model"
+    uniforms.view = glGetUniformLocation(programId, "view"); // Variável da matriz "view" em shader_vertex.glsl
+    uniforms.projection = glGetUniformLocation(programId, "projection"); // Variável da matriz "projection" em shader_vertex.glsl
+    uniforms.objectId = glGetUniformLocation(programId, "object_id"); // Variável booleana em shader_vertex.glsl
+    uniforms.sampler = glGetUniformLocation(programId, "sampler");
+    uniforms.terrainSampler = glGetUniformLocation(programId, "terrain_sampler");
+    uniforms.gouraud = glGetUniformLocation(programId, "gouraud");
+    uniforms.instanced = glGetUniformLocation(programId, "instanced");
+    uniforms.baked = glGetUniformLocation(programId, "baked");
+
+    return uniforms;
+}
+
+Renderer::Renderer(Profiler& profiler) : instances(MAX_INSTANCES), profiler(profiler){
+    this->programId = this->shaderProvider.loadShadersFromFiles();
+    this->uniforms = getProgramUniforms(this->programId);
+
+    this->cowModel.ComputeNormals();
+    this->cowModel.BuildTrianglesAndAddToVirtualScene();
+
+    this->leafModel.ComputeNormals();
+    this->leafModel.BuildTrianglesAndAddToVirtualScene();
+
+    glEnable(GL_DEPTH_TEST);
+
+    this->skyBack.load();
+    this->skyDown.load();
+    this->skyUp.load();
+    this->skyRight.load();
+    this->skyLeft.load();
+    this->skyFront.load();
+
+    this->terrainTextures.load();
+
+    this->worldPhase = profiler.addPhase("world draw", true);
+    this->modelsPhase = profiler.addPhase("model draws", true);
+}
+
+ShadersProvider& Renderer::getShadersProvider(){
+    return this->shaderProvider;
+}
+
+// Swaps the program only if the edited shaders compiled and linked
+bool Renderer::reloadShaders(){
+    GLuint reloadedProgramId = this->shaderProvider.reloadShadersFromFiles();
+
+    if (reloadedProgramId == 0) return false;
+
+    glDeleteProgram(this->programId);
+    this->programId = reloadedProgramId;
+    this->uniforms = getProgramUniforms(this->programId);
+
+    return true;
+}
+
+void Renderer::beginFrame(const glm::mat4& view, const glm::mat4& projection){
+    this->stats = RenderStats();
+
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glUseProgram(this->programId);
+
+    glUniformMatrix4fv(this->uniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(this->uniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+
+    glUniform1i(this->uniforms.sampler, 0);
+    glUniform1i(this->uniforms.terrainSampler, 1);
+    glUniform1i(this->uniforms.instanced, 0);
+}
+
+// Uploads the chunk meshes made since the last call
+void Renderer::updateTerrain(ChunkMeshQueue& meshes){
+    meshes.drain(this->chunkMeshes);
+
+    for (const ChunkMesh& mesh : this->chunkMeshes) {
+        this->terrain.upload(mesh);
+
+        if (mesh.edited) this->pendingEdits.push_back(mesh.editTime);
+    }
+}
+
+// The chunks in view, one submission per mesh page whatever their number
+// and textures; the chunk meshes are in world coordinates and already lit
+void Renderer::drawWorld(const glm::mat4& viewProjection){
+    glUniform1i(this->uniforms.gouraud, 0);
+    glUniform1i(this->uniforms.baked, 1);
+    glUniformMatrix4fv(this->uniforms.model, 1, GL_FALSE, glm::value_ptr(Matrix_Identity()));
+
+    this->stats.visibleChunks = this->terrain.cull(viewProjection);
+
+    this->terrainTextures.bind(GL_TEXTURE1);
+    this->stats.drawCalls += this->terrain.draw(this->stats.triangles);
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform1i(this->uniforms.baked, 0);
+}
+
+void Renderer::drawInstances(ObjModel& model, const char* objectName, int objectId, const std::vector<glm::mat4>& models){
+    if (models.empty()) return;
+
+    glUniform1i(this->uniforms.objectId, objectId);
+
+    size_t drawn = model.DrawVirtualObjectInstanced(objectName, this->instances, models.data(), models.size());
+
+    this->stats.drawCalls++;
+    this->stats.triangles += drawn * (g_VirtualScene[objectName].numIndexes / 3);
+}
+
+// One instanced draw per mesh, whatever the number of entities
+void Renderer::drawModels(const WorldState& state){
+    this->cowModels.clear();
+    this->leafModels.clear();
+
+    for (size_t i = 0; i < state.entityIds.size(); i++) {
+        switch(state.entityMeshes[i]){
+            case(cowMesh): this->cowModels.push_back(state.getEntityModel(i)); break;
+            case(leafMesh): this->leafModels.push_back(state.getEntityModel(i)); break;
+        }
+    }
+
+    glUniform1i(this->uniforms.gouraud, 1);
+    glUniform1i(this->uniforms.instanced, 1);
+
+    drawInstances(this->cowModel, "the_cow", COW, this->cowModels);
+    drawInstances(this->leafModel, "the_leaf", LEAF, this->leafModels);
+
+    glUniform1i(this->uniforms.instanced, 0);
+}
+
+void Renderer::render(const glm::mat4& projection, const WorldState& state){
+    glm::mat4 view = state.getView();
+
+    beginFrame(view, projection);
+
+    {
+        ScopedTimer timer(this->profiler, this->worldPhase);
+        drawWorld(projection * view);
+    }
+
+    {
+        ScopedTimer timer(this->profiler, this->modelsPhase);
+        drawModels(state);
+    }
+
+    this->instances.endFrame();
+    this->terrain.endFrame();
+
+    // Edits are visible once the frame drawing their chunks is submitted
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto editTime : this->pendingEdits) {
+        this->editLatencies.add(std::chrono::duration<double, std::milli>(now - editTime).count());
+    }
+
+    this->pendingEdits.clear();
+}
+
+RenderStats Renderer::getStats(){
+    return this->stats;
+}
+
+size_t Renderer::getChunkMeshCount(){
+    return this->terrain.size();
+}
+
+MeshMemoryStats Renderer::getMeshMemoryStats(){
+    return this->terrain.getMemoryStats();
+}
+
+// Milliseconds from block edits to the first frame showing them
+const SampleWindow& Renderer::getEditLatencies(){
+    return this->editLatencies;
+}
@@ -0,0 +1,95 @@
+#include "shader_watcher.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+using namespace std;
+
+ShaderWatcher::ShaderWatcher(){
+    #ifdef __linux__
+    this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (this->fd < 0) fprintf(stderr, "WARNING: inotify unavailable, shader hot reload disabled.\n");
+    #endif
+}
+
+ShaderWatcher::~ShaderWatcher(){
+    #ifdef __linux__
+    if (this->fd >= 0) close(this->fd);
+    #endif
+}
+
+void ShaderWatcher::watch(const char* filename){
+    string path(filename);
+    string directory = ".";
+    string name = path;
+
+    auto i = path.find_last_of("/");
+
+    if (i != string::npos){
+        directory = path.substr(0, i);
+        name = path.substr(i + 1);
+    }
+
+    #ifdef __linux__
+    if (this->fd < 0) return;
+
+    int wd = -1;
+
+    for (size_t d = 0; d < this->directories.size(); d++){
+        if (this->directories[d] == directory) wd = this->directoryWatches[d];
+    }
+
+    if (wd < 0){
+        wd = inotify_add_watch(this->fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+        if (wd < 0){
+            fprintf(stderr, "WARNING: Cannot watch \"%s\": %s\n", directory.c_str(), strerror(errno));
+            return;
+        }
+
+        this->directoryWatches.push_back(wd);
+        this->directories.push_back(directory);
+    }
+
+    this->files.push_back({wd, name});
+    #endif
+}
+
+// Drains every pending event without blocking and tells whether any of the
+// watched files changed since the last call.
+bool ShaderWatcher::poll(){
+    bool changed = false;
+
+    #ifdef __linux__
+    if (this->fd < 0) return false;
+
+    alignas(struct inotify_event) char buffer[4096];
+
+    while (true){
+        ssize_t length = read(this->fd, buffer, sizeof(buffer));
+
+        if (length <= 0) break;
+
+        for (char* ptr = buffer; ptr < buffer + length;){
+            struct inotify_event* event = (struct inotify_event*) ptr;
+
+            if (event->len > 0){
+                for (const WatchedFile& file : this->files){
+                    if (file.directoryWatch == event->wd && file.name == event->name) changed = true;
+                }
+            }
+
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    #endif
+
+    return changed;
+}
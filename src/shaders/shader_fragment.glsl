@@ -4,12 +4,16 @@ in vec4 position_world;
 in vec4 normal;
 in vec2 texture_coords;
 in vec4 gouraud_color;
+in vec4 baked_color;
+in float texture_layer;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 uniform sampler2D sampler;
+uniform sampler2DArray terrain_sampler;
 uniform int gouraud;
+uniform int baked;
 
 out vec4 color;
 
@@ -33,7 +37,11 @@ float q = 2.0;; // Expoente especular para o modelo de iluminação de Phong
 vec3 ambient_term = Ka * Ia;
 
 void main(){
-    if (gouraud == 1){
+    if (baked == 1){
+        // The terrain: all of its lighting is in the vertices
+        color.rgb = texture(terrain_sampler, vec3(texture_coords, texture_layer)).xyz * baked_color.rgb;
+        color.a = 1.0;
+    } else if (gouraud == 1){
         color = gouraud_color;
     } else {
         vec4 camera_position = inverse(view) * origin;
@@ -57,4 +65,4 @@ void main(){
 
         color.a = 1.0;
     }
-} 
\ No newline at end of file
+} 
\ No newline at end of file
@@ -3,17 +3,27 @@
 layout (location = 0) in vec4 model_coefficients;
 layout (location = 1) in vec4 normal_coefficients;
 layout (location = 2) in vec2 texture_coefficients;
+// Per instance model matrix, used instead of "model" when "instanced" is 1
+layout (location = 3) in mat4 instance_model;
+// Light baked into the terrain vertices, used when "baked" is 1
+layout (location = 7) in vec4 light_coefficients;
+// Layer of the terrain texture array, used when "baked" is 1
+layout (location = 8) in float layer_coefficient;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 uniform sampler2D sampler;
 uniform int gouraud;
+uniform int instanced;
+uniform int baked;
 
 out vec2 texture_coords;
 out vec4 position_world;
 out vec4 normal;
 out vec4 gouraud_color;
+out vec4 baked_color;
+out float texture_layer;
 
 vec4 origin = vec4(0.0, 2.0, 1.0, 1.0);
 
@@ -35,14 +45,18 @@ float q = 2.0;; // Expoente especular para o modelo de iluminação de Phong
 vec3 ambient_term = Ka * Ia;
 
 void main(){
-    position_world = model * model_coefficients;
+    mat4 model_matrix = instanced == 1 ? instance_model : model;
+
+    position_world = model_matrix * model_coefficients;
     texture_coords = texture_coefficients;
 
-    normal = inverse(transpose(model)) * normal_coefficients;
+    normal = inverse(transpose(model_matrix)) * normal_coefficients;
     normal.w = 0.0;
 
     gl_Position = projection * view * position_world;
     gouraud_color = vec4(0.0f, 0.0f, 0.0f, 0.0f);
+    baked_color = light_coefficients;
+    texture_layer = layer_coefficient;
 
     if (gouraud == 1){
         vec4 camera_position = inverse(view) * origin;
@@ -66,4 +80,4 @@ void main(){
 
         gouraud_color.a = 1.0;
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
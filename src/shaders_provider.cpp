@@ -1,13 +1,39 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 #include "shaders_provider.hpp"
 #include "program.hpp"
+#include "gl_extensions.hpp"
 
 using namespace std;
 
-void ShadersProvider::loadShader(const char* filename, GLuint shaderId){
+// Header written in front of every cached program binary
+struct ProgramCacheHeader {
+    char magic[4];
+    uint32_t binaryFormat;
+    uint64_t key;
+    uint64_t length;
+};
+
+static const char programCacheMagic[4] = {'M', 'G', 'L', 'B'};
+
+// 64-bit FNV-1a, chained through "hash" so several strings can be combined
+static uint64_t hashString(const char* data, size_t length, uint64_t hash = 14695981039346656037ULL){
+    for (size_t i = 0; i < length; i++){
+        hash ^= (unsigned char) data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+bool ShadersProvider::readShaderFile(const char* filename, string& source){
     ifstream file;
 
     try {
@@ -15,14 +41,19 @@ void ShadersProvider::loadShader(const char* filename, GLuint shaderId){
         file.open(filename);
     }catch (exception& e){
         fprintf(stderr, "ERROR: Cannot open file \"%s\".\n", filename);
-        exit(EXIT_FAILURE);
+        return false;
     }
 
     stringstream shader;
     shader << file.rdbuf();
-    string str = shader.str();
-    const GLchar* shaderString = str.c_str();
-    const GLint shaderStringLenght = static_cast<GLint>( str.length() );
+    source = shader.str();
+
+    return true;
+}
+
+bool ShadersProvider::loadShader(const char* filename, const string& source, GLuint shaderId){
+    const GLchar* shaderString = source.c_str();
+    const GLint shaderStringLenght = static_cast<GLint>( source.length() );
 
     glShaderSource(shaderId, 1, &shaderString, &shaderStringLenght);
 
@@ -34,7 +65,8 @@ void ShadersProvider::loadShader(const char* filename, GLuint shaderId){
     GLint logLenght = 0;
     glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &logLenght);
 
-    GLchar* log = new GLchar[logLenght];
+    GLchar* log = new GLchar[logLenght + 1];
+    log[0] = '\0';
     glGetShaderInfoLog(shaderId, logLenght, &logLenght, log);
 
     if (logLenght != 0){
@@ -60,23 +92,186 @@ void ShadersProvider::loadShader(const char* filename, GLuint shaderId){
     }
 
     delete [] log;
+
+    return compiled == GL_TRUE;
 }
 
-GLuint ShadersProvider::loadShaderByType(const char* filename, GLenum shaderType){
+GLuint ShadersProvider::loadShaderByType(const char* filename, const string& source, GLenum shaderType){
     GLuint shaderId = glCreateShader(shaderType);
 
-    loadShader(filename, shaderId);
+    if (!loadShader(filename, source, shaderId)){
+        glDeleteShader(shaderId);
+        return 0;
+    }
 
     return shaderId;
 }
 
-GLuint ShadersProvider::loadShadersFromFiles(){
-    this->vertexShader = loadShaderByType(vertexShaderFilename, GL_VERTEX_SHADER);
-    this->fragmentShader = loadShaderByType(fragmentShaderFilename, GL_FRAGMENT_SHADER);
+// Compiles and links both sources, returning 0 (and leaving nothing behind)
+// if any of the steps fails. The linked binary is stored in the cache.
+GLuint ShadersProvider::buildProgram(const string& vertexSource, const string& fragmentSource, uint64_t key){
+    GLuint vertexShader = loadShaderByType(vertexShaderFilename, vertexSource, GL_VERTEX_SHADER);
+    GLuint fragmentShader = loadShaderByType(fragmentShaderFilename, fragmentSource, GL_FRAGMENT_SHADER);
+
+    GLuint programId = 0;
+
+    if (vertexShader != 0 && fragmentShader != 0){
+        Program program = Program();
+
+        if (program.createGpuProgram(vertexShader, fragmentShader)){
+            programId = program.getId();
+            saveProgramToCache(key, program);
+        }else{
+            glDeleteProgram(program.getId());
+        }
+    }
+
+    // Shaders attached to a program are only freed together with it
+    if (vertexShader != 0) glDeleteShader(vertexShader);
+    if (fragmentShader != 0) glDeleteShader(fragmentShader);
+
+    return programId;
+}
+
+string ShadersProvider::getCacheFilename(){
+    uint64_t hash = hashString(vertexShaderFilename, strlen(vertexShaderFilename));
+    hash = hashString(fragmentShaderFilename, strlen(fragmentShaderFilename) + 1, hash);
+
+    char filename[64];
+    snprintf(filename, sizeof(filename), "/program_%016llx.bin", (unsigned long long) hash);
+
+    return string(cacheDirectory) + filename;
+}
+
+// The key covers both sources and the driver identification, so editing a
+// shader or updating the driver invalidates the cached binary.
+uint64_t ShadersProvider::getCacheKey(const string& vertexSource, const string& fragmentSource){
+    const char* driver[] = {
+        (const char*) glGetString(GL_VENDOR),
+        (const char*) glGetString(GL_RENDERER),
+        (const char*) glGetString(GL_VERSION)
+    };
+
+    uint64_t hash = hashString(vertexSource.c_str(), vertexSource.length() + 1);
+    hash = hashString(fragmentSource.c_str(), fragmentSource.length() + 1, hash);
+
+    for (const char* info : driver){
+        if (info != NULL) hash = hashString(info, strlen(info) + 1, hash);
+    }
+
+    return hash;
+}
+
+GLuint ShadersProvider::loadProgramFromCache(uint64_t key){
+    if (!GLEXT_ARB_get_program_binary) return 0;
+
+    ifstream file(getCacheFilename(), ios::binary);
+    if (!file.is_open()) return 0;
+
+    ProgramCacheHeader header;
+    file.read((char*) &header, sizeof(header));
+
+    if (!file || memcmp(header.magic, programCacheMagic, sizeof(programCacheMagic)) != 0 || header.key != key) return 0;
+
+    // The binary must be exactly the rest of the file, so a truncated or
+    // corrupt cache never makes us allocate what its header claims
+    streampos start = file.tellg();
+    file.seekg(0, ios::end);
+    streamoff remaining = file.tellg() - start;
+    file.seekg(start);
+
+    if (!file || header.length == 0 || remaining != (streamoff) header.length) return 0;
+
+    vector<char> binary(header.length);
+    file.read(binary.data(), binary.size());
+
+    if (!file) return 0;
 
     Program program = Program();
 
-    program.createGpuProgram(this->vertexShader, this->fragmentShader);
+    if (!program.createGpuProgramFromBinary(header.binaryFormat, binary)) return 0;
 
     return program.getId();
-}
\ No newline at end of file
+}
+
+void ShadersProvider::saveProgramToCache(uint64_t key, Program& program){
+    GLenum binaryFormat = 0;
+    vector<char> binary;
+
+    if (!program.getBinary(binaryFormat, binary)) return;
+
+    error_code error;
+    filesystem::create_directories(cacheDirectory, error);
+
+    ofstream file(getCacheFilename(), ios::binary | ios::trunc);
+
+    if (!file.is_open()){
+        fprintf(stderr, "WARNING: Cannot write program cache \"%s\".\n", getCacheFilename().c_str());
+        return;
+    }
+
+    ProgramCacheHeader header;
+    memcpy(header.magic, programCacheMagic, sizeof(programCacheMagic));
+    header.binaryFormat = binaryFormat;
+    header.key = key;
+    header.length = binary.size();
+
+    file.write((const char*) &header, sizeof(header));
+    file.write(binary.data(), binary.size());
+}
+
+GLuint ShadersProvider::loadShadersFromFiles(){
+    auto start = chrono::steady_clock::now();
+
+    string vertexSource, fragmentSource;
+
+    if (!readShaderFile(vertexShaderFilename, vertexSource) || !readShaderFile(fragmentShaderFilename, fragmentSource)){
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t key = getCacheKey(vertexSource, fragmentSource);
+
+    GLuint programId = loadProgramFromCache(key);
+    bool cacheHit = programId != 0;
+
+    if (!cacheHit) programId = buildProgram(vertexSource, fragmentSource, key);
+
+    if (programId == 0){
+        fprintf(stderr, "ERROR: Cannot build the GPU program.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    printf("Shaders loaded in %.2f ms (%s)\n", elapsed, cacheHit ? "program binary cache" : "compiled");
+
+    return programId;
+}
+
+// Used for hot reloading: on any failure the error is reported and 0 is
+// returned, so the caller keeps using its current program.
+GLuint ShadersProvider::reloadShadersFromFiles(){
+    string vertexSource, fragmentSource;
+
+    if (!readShaderFile(vertexShaderFilename, vertexSource) || !readShaderFile(fragmentShaderFilename, fragmentSource)){
+        return 0;
+    }
+
+    GLuint programId = buildProgram(vertexSource, fragmentSource, getCacheKey(vertexSource, fragmentSource));
+
+    if (programId == 0){
+        fprintf(stderr, "ERROR: Shader reload failed, keeping the previous program.\n");
+    }else{
+        printf("Shaders reloaded.\n");
+    }
+
+    return programId;
+}
+
+const char* ShadersProvider::getVertexShaderFilename(){
+    return this->vertexShaderFilename;
+}
+
+const char* ShadersProvider::getFragmentShaderFilename(){
+    return this->fragmentShaderFilename;
+}
@@ -0,0 +1,79 @@
+#include "simulation.hpp"
+
+#include <algorithm>
+
+// Longest delay the simulation tries to catch up on, in seconds. Beyond it
+// the simulation slows down instead of running a burst of ticks.
+#define MAX_CATCH_UP 0.25
+
+// Ticks between two reports of the simulation profiler
+#define REPORT_TICKS 60
+
+typedef std::chrono::steady_clock Clock;
+
+static FrameSnapshot makeSnapshot(World& world){
+    FrameSnapshot snapshot;
+
+    snapshot.previous = world.getPreviousState();
+    snapshot.current = world.getCurrentState();
+    snapshot.publishTime = Clock::now();
+
+    return snapshot;
+}
+
+Simulation::Simulation(World& world, Profiler& profiler) : world(world), profiler(profiler), snapshots(makeSnapshot(world)){
+}
+
+Simulation::~Simulation(){
+    stop();
+}
+
+void Simulation::start(){
+    if (this->running) return;
+
+    this->running = true;
+    this->thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop(){
+    this->running = false;
+
+    if (this->thread.joinable()) this->thread.join();
+}
+
+void Simulation::run(){
+    const Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SIMULATION_STEP));
+    const Clock::duration maxCatchUp = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(MAX_CATCH_UP));
+
+    Clock::time_point nextTick = Clock::now();
+    long ticks = 0;
+
+    while (this->running) {
+        this->profiler.beginFrame();
+        this->world.tick();
+        this->profiler.endFrame();
+
+        this->snapshots.getBack() = makeSnapshot(this->world);
+        this->snapshots.publish();
+
+        if (++ticks % REPORT_TICKS == 0) this->profiler.report();
+
+        nextTick += step;
+
+        Clock::time_point now = Clock::now();
+        if (now - nextTick > maxCatchUp) nextTick = now;
+
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+// Latest tick, interpolated by the time elapsed since it was published. The
+// rendered state trails the simulation by at most one tick.
+WorldState Simulation::getState(){
+    const FrameSnapshot& snapshot = this->snapshots.read();
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - snapshot.publishTime).count();
+    float alpha = (float) std::min(std::max(elapsed / SIMULATION_STEP, 0.0), 1.0);
+
+    return interpolateStates(snapshot.previous, snapshot.current, alpha);
+}
@@ -0,0 +1,116 @@
+#include "spatial_hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(float cellSize){
+    this->cellSize = cellSize;
+}
+
+glm::ivec3 SpatialHash::getCell(glm::vec3 position) const {
+    return glm::ivec3(glm::floor(position / this->cellSize));
+}
+
+uint32_t SpatialHash::getBucket(glm::ivec3 cell) const {
+    uint32_t hash = ((uint32_t) cell.x * 73856093u) ^ ((uint32_t) cell.y * 19349663u) ^ ((uint32_t) cell.z * 83492791u);
+
+    // The bucket count is a power of two
+    return hash & (uint32_t) (this->bucketStarts.size() - 2);
+}
+
+void SpatialHash::build(const EntityStore& entities){
+    size_t count = entities.size();
+
+    // About two buckets per entity keeps the unrelated cells sharing one rare
+    size_t buckets = 64;
+    while (buckets < 2 * count) buckets *= 2;
+
+    this->bucketStarts.assign(buckets + 1, 0);
+    this->entityCells.resize(count);
+    this->maxRadius = 0.0f;
+
+    const glm::vec3* positions = entities.positions.data();
+    const Collider* colliders = entities.colliders.data();
+
+    size_t stored = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (colliders[i].radius <= 0.0f) continue;
+
+        glm::ivec3 cell = getCell(positions[i]);
+
+        this->entityCells[i] = cell;
+        this->bucketStarts[getBucket(cell) + 1]++;
+        this->maxRadius = std::max(this->maxRadius, colliders[i].radius);
+        stored++;
+    }
+
+    for (size_t bucket = 0; bucket < buckets; bucket++) this->bucketStarts[bucket + 1] += this->bucketStarts[bucket];
+
+    this->entries.resize(stored);
+    this->entryCells.resize(stored);
+
+    std::vector<uint32_t> cursors(this->bucketStarts.begin(), this->bucketStarts.end() - 1);
+
+    for (size_t i = 0; i < count; i++) {
+        if (colliders[i].radius <= 0.0f) continue;
+
+        uint32_t entry = cursors[getBucket(this->entityCells[i])]++;
+
+        this->entries[entry] = (uint32_t) i;
+        this->entryCells[entry] = this->entityCells[i];
+    }
+}
+
+// Appends every entity whose collider might overlap the sphere to
+// "candidates"
+void SpatialHash::query(glm::vec3 center, float radius, std::vector<uint32_t>& candidates) const {
+    if (this->entries.empty()) return;
+
+    float reach = radius + this->maxRadius;
+    glm::ivec3 low = getCell(center - glm::vec3(reach));
+    glm::ivec3 high = getCell(center + glm::vec3(reach));
+
+    for (int x = low.x; x <= high.x; x++) {
+        for (int y = low.y; y <= high.y; y++) {
+            for (int z = low.z; z <= high.z; z++) {
+                glm::ivec3 cell = glm::ivec3(x, y, z);
+                uint32_t bucket = getBucket(cell);
+
+                for (uint32_t k = this->bucketStarts[bucket]; k < this->bucketStarts[bucket + 1]; k++) {
+                    if (this->entryCells[k] == cell) candidates.push_back(this->entries[k]);
+                }
+            }
+        }
+    }
+}
+
+// The own cell and the 13 neighbours after it, in x, y, z order: each pair of
+// neighbouring cells is visited from only one of its cells.
+static const glm::ivec3 forwardCells[14] = {
+    glm::ivec3(0, 0, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 1, -1), glm::ivec3(0, 1, 0), glm::ivec3(0, 1, 1),
+    glm::ivec3(1, -1, -1), glm::ivec3(1, -1, 0), glm::ivec3(1, -1, 1), glm::ivec3(1, 0, -1), glm::ivec3(1, 0, 0),
+    glm::ivec3(1, 0, 1), glm::ivec3(1, 1, -1), glm::ivec3(1, 1, 0), glm::ivec3(1, 1, 1)
+};
+
+// Every pair of entities in the same or neighbouring cells, once
+void SpatialHash::findPairs(std::vector<CandidatePair>& pairs) const {
+    for (size_t entry = 0; entry < this->entries.size(); entry++) {
+        uint32_t i = this->entries[entry];
+        glm::ivec3 center = this->entryCells[entry];
+
+        // Within the own cell, only the entities stored after this one
+        for (uint32_t k = entry + 1; k < this->bucketStarts[getBucket(center) + 1]; k++) {
+            if (this->entryCells[k] == center) pairs.push_back(CandidatePair(i, this->entries[k]));
+        }
+
+        for (int neighbour = 1; neighbour < 14; neighbour++) {
+            glm::ivec3 cell = center + forwardCells[neighbour];
+            uint32_t bucket = getBucket(cell);
+
+            for (uint32_t k = this->bucketStarts[bucket]; k < this->bucketStarts[bucket + 1]; k++) {
+                if (this->entryCells[k] == cell) pairs.push_back(CandidatePair(i, this->entries[k]));
+            }
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#include "stream_buffer.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "gl_extensions.hpp"
+
+// "sectionSize" is the number of bytes one frame can write
+StreamBuffer::StreamBuffer(size_t sectionSize){
+    this->sectionSize = sectionSize;
+    this->persistent = GLEXT_ARB_buffer_storage;
+
+    GLsizeiptr size = SECTIONS * sectionSize;
+
+    glGenBuffers(1, &this->bufferId);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->bufferId);
+
+    if (this->persistent){
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+        this->mapping = (uint8_t*) glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+
+        if (this->mapping == NULL){
+            fprintf(stderr, "ERROR: Cannot map a stream buffer.\n");
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+StreamBuffer::~StreamBuffer(){
+    for (GLsync fence : this->fences){
+        if (fence != NULL) glDeleteSync(fence);
+    }
+
+    glDeleteBuffers(1, &this->bufferId);
+}
+
+void StreamBuffer::waitForSection(int section){
+    GLsync fence = this->fences[section];
+
+    if (fence == NULL) return;
+
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(fence);
+    this->fences[section] = NULL;
+}
+
+// Copies "size" bytes to this frame's section, at a multiple of "alignment",
+// and sets "offset" to where in the buffer they went. False, writing
+// nothing, when they do not fit in what is left of the section.
+bool StreamBuffer::write(const void* data, size_t size, size_t alignment, GLintptr& offset){
+    size_t start = (this->used + alignment - 1) / alignment * alignment;
+
+    if (size == 0 || start + size > this->sectionSize) return false;
+
+    offset = this->section * this->sectionSize + start;
+
+    if (this->persistent){
+        memcpy(this->mapping + offset, data, size);
+    } else {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, this->bufferId);
+        void* range = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, flags);
+        memcpy(range, data, size);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    this->used = start + size;
+
+    return true;
+}
+
+// Bytes still free in this frame's section, past the next multiple of
+// "alignment"
+size_t StreamBuffer::getRemaining(size_t alignment){
+    size_t start = (this->used + alignment - 1) / alignment * alignment;
+
+    return start < this->sectionSize ? this->sectionSize - start : 0;
+}
+
+// Moves on to the next section once the draws of this frame are issued.
+// Persistent buffers fence them and only wait if the GPU is still SECTIONS
+// frames behind; the others are orphaned whenever the ring starts over.
+void StreamBuffer::endFrame(){
+    if (this->persistent) this->fences[this->section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    this->section = (this->section + 1) % SECTIONS;
+    this->used = 0;
+
+    if (this->persistent){
+        waitForSection(this->section);
+    } else if (this->section == 0){
+        glBindBuffer(GL_COPY_WRITE_BUFFER, this->bufferId);
+        glBufferData(GL_COPY_WRITE_BUFFER, SECTIONS * this->sectionSize, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+GLuint StreamBuffer::getId(){
+    return this->bufferId;
+}
+
+bool StreamBuffer::isPersistent(){
+    return this->persistent;
+}
@@ -0,0 +1,235 @@
+#include "terrain_generator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <thread>
+
+// Height of the plains, and how much higher hills and plains rise above it
+#define TERRAIN_BASE -20
+#define PLAINS_HEIGHT 10.0f
+#define HILLS_HEIGHT 28.0f
+
+// Blocks of dirt under the grass
+#define DIRT_DEPTH 3
+
+// Caves stay this far under the surface and above this height
+#define CAVE_ROOF_DEPTH 5
+#define CAVE_FLOOR -44
+
+// The higher, the fewer and thinner the caves
+#define CAVE_THRESHOLD 0.68f
+
+// Width of the dithered border between plains and hills, in biome noise
+#define BIOME_DITHER 0.15f
+
+const char* generatorStageNames[GENERATOR_STAGES] = {"heights", "strata", "caves", "biomes"};
+
+// Independent noises from the same seed
+enum NoiseLayer { biomeNoise, plainsNoise, hillsNoise, caveNoise, ditherNoise };
+
+static uint32_t hash(int x, int y, int z, uint32_t seed){
+    uint32_t h = seed * 0x9e3779b9u;
+
+    h ^= (uint32_t) x * 0x85ebca6bu;
+    h = (h ^ (h >> 15)) * 0x2c1b3c6du;
+    h ^= (uint32_t) y * 0xc2b2ae35u;
+    h = (h ^ (h >> 13)) * 0x297a2d39u;
+    h ^= (uint32_t) z * 0x27d4eb2fu;
+    h = (h ^ (h >> 16)) * 0x85ebca6bu;
+
+    return h ^ (h >> 16);
+}
+
+// In [0, 1)
+static float random01(int x, int y, int z, uint32_t seed){
+    return (hash(x, y, z, seed) >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline float fade(float t){
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// Smoothly interpolated random values at the integer points, in [0, 1)
+static float valueNoise(float x, float y, float z, uint32_t seed){
+    int x0 = (int) floorf(x), y0 = (int) floorf(y), z0 = (int) floorf(z);
+    float tx = fade(x - x0), ty = fade(y - y0), tz = fade(z - z0);
+
+    float corners[2][2];
+
+    for (int dy = 0; dy < 2; dy++) {
+        for (int dz = 0; dz < 2; dz++) {
+            float a = random01(x0, y0 + dy, z0 + dz, seed);
+            float b = random01(x0 + 1, y0 + dy, z0 + dz, seed);
+
+            corners[dy][dz] = a + (b - a) * tx;
+        }
+    }
+
+    float bottom = corners[0][0] + (corners[0][1] - corners[0][0]) * tz;
+    float top = corners[1][0] + (corners[1][1] - corners[1][0]) * tz;
+
+    return bottom + (top - bottom) * ty;
+}
+
+// Octaves of value noise, each twice the frequency and half the weight of
+// the previous one, in [0, 1). 2D noises keep y at 0.
+static float fractalNoise(float x, float y, float z, int octaves, uint32_t seed){
+    float sum = 0.0f, weight = 1.0f, weights = 0.0f;
+
+    for (int octave = 0; octave < octaves; octave++) {
+        sum += valueNoise(x, y, z, seed + octave) * weight;
+        weights += weight;
+
+        x *= 2.0f;
+        y *= 2.0f;
+        z *= 2.0f;
+        weight *= 0.5f;
+    }
+
+    return sum / weights;
+}
+
+TerrainGenerator::TerrainGenerator(unsigned int seed){
+    this->seed = seed;
+}
+
+// 0 in plains, 1 in hills
+float TerrainGenerator::getBiome(int x, int z) const {
+    float noise = fractalNoise(x / 40.0f, 0.0f, z / 40.0f, 2, hash(biomeNoise, 0, 0, this->seed));
+    float t = glm::clamp((noise - 0.4f) / 0.2f, 0.0f, 1.0f);
+
+    return t * t * (3.0f - 2.0f * t);
+}
+
+int TerrainGenerator::getHeight(int x, int z, float biome) const {
+    float plains = fractalNoise(x / 32.0f, 0.0f, z / 32.0f, 4, hash(plainsNoise, 0, 0, this->seed)) * PLAINS_HEIGHT;
+    float hills = fractalNoise(x / 24.0f, 0.0f, z / 24.0f, 5, hash(hillsNoise, 0, 0, this->seed)) * HILLS_HEIGHT;
+
+    return TERRAIN_BASE + (int) roundf(plains + (hills - plains) * biome);
+}
+
+// Height of the top block of the column, before caves
+int TerrainGenerator::getHeight(int x, int z) const {
+    return getHeight(x, z, getBiome(x, z));
+}
+
+// Fills "blocks", which must be empty, with chunk "chunk", adding the time
+// of every stage to "stageMilliseconds"
+void TerrainGenerator::generate(glm::ivec3 chunk, Chunk& blocks, double stageMilliseconds[GENERATOR_STAGES]) const {
+    glm::ivec3 base = chunk * CHUNK_SIZE;
+    int heights[CHUNK_SIZE][CHUNK_SIZE];
+    float biomes[CHUNK_SIZE][CHUNK_SIZE];
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto lap = [&](GeneratorStage stage){
+        auto now = std::chrono::steady_clock::now();
+        stageMilliseconds[stage] += std::chrono::duration<double, std::milli>(now - start).count();
+        start = now;
+    };
+
+    int highest = base.y - 1;
+
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            biomes[z][x] = getBiome(base.x + x, base.z + z);
+            heights[z][x] = getHeight(base.x + x, base.z + z, biomes[z][x]);
+            highest = std::max(highest, heights[z][x]);
+        }
+    }
+
+    lap(heightsStage);
+
+    // Chunks above the surface stay empty
+    if (highest < base.y) return;
+
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            int top = std::min(heights[z][x] - base.y, CHUNK_SIZE - 1);
+
+            for (int y = 0; y <= top; y++) {
+                int depth = heights[z][x] - (base.y + y);
+                blocks.set(glm::ivec3(x, y, z), depth == 0 ? grass : depth <= DIRT_DEPTH ? dirt : stone);
+            }
+        }
+    }
+
+    lap(strataStage);
+
+    uint32_t caveSeed = hash(caveNoise, 0, 0, this->seed);
+
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            int roof = std::min(heights[z][x] - CAVE_ROOF_DEPTH - base.y, CHUNK_SIZE - 1);
+
+            for (int y = std::max(CAVE_FLOOR - base.y, 0); y <= roof; y++) {
+                glm::vec3 position = glm::vec3(base + glm::ivec3(x, y, z));
+
+                // Squashed vertically, so caves are wider than tall
+                float noise = fractalNoise(position.x / 20.0f, position.y / 12.0f, position.z / 20.0f, 2, caveSeed);
+                if (noise > CAVE_THRESHOLD) blocks.set(glm::ivec3(x, y, z), air);
+            }
+        }
+    }
+
+    lap(cavesStage);
+
+    uint32_t ditherSeed = hash(ditherNoise, 0, 0, this->seed);
+
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            float jitter = (random01(base.x + x, 0, base.z + z, ditherSeed) - 0.5f) * 2.0f * BIOME_DITHER;
+            if (biomes[z][x] + jitter <= 0.5f) continue;
+
+            // Grass and dirt of hills turn to stone
+            int top = std::min(heights[z][x] - base.y, CHUNK_SIZE - 1);
+            int bottom = std::max(heights[z][x] - DIRT_DEPTH - base.y, 0);
+
+            for (int y = bottom; y <= top; y++) {
+                if (blocks.get(glm::ivec3(x, y, z)) != air) blocks.set(glm::ivec3(x, y, z), stone);
+            }
+        }
+    }
+
+    lap(biomesStage);
+}
+
+void generateChunks(const TerrainGenerator& generator, const std::vector<glm::ivec3>& chunks,
+                    std::vector<std::unique_ptr<Chunk>>& generated, GeneratorTimings& timings){
+    auto start = std::chrono::steady_clock::now();
+
+    generated.clear();
+    generated.resize(chunks.size());
+
+    std::atomic<size_t> next(0);
+    std::mutex mutex;
+
+    // Threads take the next chunk until there are none left
+    auto work = [&](){
+        double stageMilliseconds[GENERATOR_STAGES] = {};
+
+        for (size_t i = next++; i < chunks.size(); i = next++) {
+            std::unique_ptr<Chunk> blocks(new Chunk());
+            generator.generate(chunks[i], *blocks, stageMilliseconds);
+
+            if (!blocks->isEmpty()) generated[i] = std::move(blocks);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int stage = 0; stage < GENERATOR_STAGES; stage++) timings.stageMilliseconds[stage] += stageMilliseconds[stage];
+    };
+
+    unsigned int threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int) chunks.size()));
+    std::vector<std::thread> threads;
+
+    for (unsigned int t = 1; t < threadCount; t++) threads.emplace_back(work);
+    work();
+
+    for (std::thread& thread : threads) thread.join();
+
+    timings.chunks += chunks.size();
+    timings.wallMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,389 @@
+#include "terrain_meshes.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "gl_extensions.hpp"
+
+TerrainMeshes::MeshPage::MeshPage(uint32_t vertexCapacity, uint32_t indexCapacity)
+    : vertices(vertexCapacity, TERRAIN_MIN_VERTICES), indices(indexCapacity, TERRAIN_MIN_INDICES){
+    this->vertexCapacity = vertexCapacity;
+    this->indexCapacity = indexCapacity;
+
+    glGenVertexArrays(1, &this->vertexArrayId);
+    glGenBuffers(1, &this->vertexBufferId);
+    glGenBuffers(1, &this->indexBufferId);
+
+    glBindVertexArray(this->vertexArrayId);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBufferId);
+    glBufferData(GL_ARRAY_BUFFER, (size_t) vertexCapacity * sizeof(TerrainVertex), NULL, GL_DYNAMIC_DRAW);
+
+    GLsizei stride = sizeof(TerrainVertex);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(TerrainVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_BYTE, GL_TRUE, stride, (void*) offsetof(TerrainVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(TerrainVertex, textureCoords));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(7, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*) offsetof(TerrainVertex, light));
+    glEnableVertexAttribArray(7);
+    glVertexAttribPointer(8, 1, GL_UNSIGNED_BYTE, GL_FALSE, stride, (void*) offsetof(TerrainVertex, layer));
+    glEnableVertexAttribArray(8);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBufferId);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (size_t) indexCapacity * sizeof(uint32_t), NULL, GL_DYNAMIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+TerrainMeshes::MeshPage::~MeshPage(){
+    glDeleteVertexArrays(1, &this->vertexArrayId);
+    glDeleteBuffers(1, &this->vertexBufferId);
+    glDeleteBuffers(1, &this->indexBufferId);
+}
+
+TerrainMeshes::TerrainMeshes() : staging(TERRAIN_STAGING_SIZE), indirectCommands(TERRAIN_MAX_DRAWS * sizeof(DrawCommand)){
+    this->indirect = GLEXT_ARB_multi_draw_indirect;
+    this->pages.push_back(std::make_unique<MeshPage>(TERRAIN_PAGE_VERTICES, TERRAIN_PAGE_INDICES));
+}
+
+// Smallest power of two not below "size", and not below "minimum"
+static uint32_t getPageCapacity(uint32_t size, uint32_t minimum){
+    uint32_t capacity = minimum;
+
+    while (capacity < size) capacity *= 2;
+
+    return capacity;
+}
+
+// Ranges for the mesh of "chunk" in "page", all or nothing
+bool TerrainMeshes::allocate(MeshPage& page, GpuChunk& chunk){
+    if (!page.vertices.allocate(chunk.vertexCount, chunk.firstVertex)) return false;
+
+    if (!page.indices.allocate(chunk.indexCount, chunk.firstIndex)){
+        page.vertices.free(chunk.firstVertex);
+        return false;
+    }
+
+    chunk.page = &page;
+
+    return true;
+}
+
+// Finds room for the mesh of "chunk": in the first page with free ranges big
+// enough, else in a page defragmented to make them, else in a new page
+void TerrainMeshes::place(GpuChunk& chunk){
+    for (auto& page : this->pages){
+        if (allocate(*page, chunk)) return;
+    }
+
+    for (auto& page : this->pages){
+        if (page->packed) continue;
+        if (page->vertices.getStats().getFree() < chunk.vertexCount) continue;
+        if (page->indices.getStats().getFree() < chunk.indexCount) continue;
+
+        defragment(page);
+
+        if (allocate(*page, chunk)) return;
+    }
+
+    uint32_t vertexCapacity = getPageCapacity(chunk.vertexCount, TERRAIN_PAGE_VERTICES);
+    uint32_t indexCapacity = getPageCapacity(chunk.indexCount, TERRAIN_PAGE_INDICES);
+
+    this->pages.push_back(std::make_unique<MeshPage>(vertexCapacity, indexCapacity));
+    allocate(*this->pages.back(), chunk);
+}
+
+void TerrainMeshes::retire(const GpuChunk& chunk){
+    this->retired.push_back({chunk.page, chunk.firstVertex, chunk.firstIndex, this->frame});
+}
+
+// Packs the meshes of "page" into a new page of the same size, copying them
+// on the GPU. Handing out ranges from largest to smallest leaves no gaps in
+// a buddy allocator, so the free memory ends up in as few blocks as it can.
+// Retired ranges are not copied: the old buffers outlive the draws still
+// reading them, as OpenGL only deletes them once the GPU is done.
+void TerrainMeshes::defragment(std::unique_ptr<MeshPage>& page){
+    MeshPage* old = page.get();
+    std::unique_ptr<MeshPage> packed = std::make_unique<MeshPage>(old->vertexCapacity, old->indexCapacity);
+    std::vector<GpuChunk*> moved;
+
+    for (auto& entry : this->chunks){
+        if (entry.second.page == old) moved.push_back(&entry.second);
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, old->vertexBufferId);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, packed->vertexBufferId);
+
+    std::sort(moved.begin(), moved.end(), [](const GpuChunk* a, const GpuChunk* b){
+        return a->vertexCount > b->vertexCount;
+    });
+
+    for (GpuChunk* chunk : moved){
+        uint32_t firstVertex;
+        packed->vertices.allocate(chunk->vertexCount, firstVertex);
+
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, chunk->firstVertex * sizeof(TerrainVertex),
+                            firstVertex * sizeof(TerrainVertex), chunk->vertexCount * sizeof(TerrainVertex));
+
+        chunk->firstVertex = firstVertex;
+        chunk->page = packed.get();
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, old->indexBufferId);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, packed->indexBufferId);
+
+    std::sort(moved.begin(), moved.end(), [](const GpuChunk* a, const GpuChunk* b){
+        return a->indexCount > b->indexCount;
+    });
+
+    for (GpuChunk* chunk : moved){
+        uint32_t firstIndex;
+        packed->indices.allocate(chunk->indexCount, firstIndex);
+
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, chunk->firstIndex * sizeof(uint32_t),
+                            firstIndex * sizeof(uint32_t), chunk->indexCount * sizeof(uint32_t));
+
+        chunk->firstIndex = firstIndex;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    this->retired.erase(std::remove_if(this->retired.begin(), this->retired.end(),
+                                       [old](const RetiredRange& range){ return range.page == old; }),
+                        this->retired.end());
+
+    packed->packed = true;
+    page = std::move(packed);
+    this->defragmentations++;
+}
+
+// The first page is kept, even empty, for the meshes to come
+void TerrainMeshes::releaseEmptyPages(){
+    for (size_t i = this->pages.size() - 1; i > 0; i--){
+        if (this->pages[i]->vertices.getStats().allocations == 0) this->pages.erase(this->pages.begin() + i);
+    }
+}
+
+// Copies "size" bytes to "offset" in "bufferId", through the staging buffer
+// when they fit in it
+void TerrainMeshes::fill(GLuint bufferId, size_t offset, const void* data, size_t size){
+    GLintptr stagingOffset;
+    bool staged = this->staging.write(data, size, sizeof(uint32_t), stagingOffset);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bufferId);
+
+    if (staged){
+        glBindBuffer(GL_COPY_READ_BUFFER, this->staging.getId());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, stagingOffset, offset, size);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    } else {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Empty meshes just drop the chunk
+void TerrainMeshes::upload(const ChunkMesh& mesh){
+    uint64_t key = getChunkKey(mesh.chunk);
+    auto found = this->chunks.find(key);
+
+    if (found != this->chunks.end()){
+        retire(found->second);
+        this->chunks.erase(found);
+    }
+
+    if (mesh.indices.empty()) return;
+
+    GpuChunk chunk;
+    chunk.chunk = mesh.chunk;
+    chunk.vertexCount = mesh.vertices.size();
+    chunk.indexCount = mesh.indices.size();
+
+    place(chunk);
+
+    fill(chunk.page->vertexBufferId, chunk.firstVertex * sizeof(TerrainVertex),
+         mesh.vertices.data(), mesh.vertices.size() * sizeof(TerrainVertex));
+    fill(chunk.page->indexBufferId, chunk.firstIndex * sizeof(uint32_t),
+         mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+
+    this->chunks.emplace(key, chunk);
+}
+
+// Planes of the frustum of "viewProjection", pointing inwards, as extracted
+// by Gribb and Hartmann: a point p is inside plane i when
+// dot(planes[i], (p, 1)) >= 0
+static void getFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]){
+    glm::vec4 rows[4];
+
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        planes[2 * i] = rows[3] + rows[i];
+        planes[2 * i + 1] = rows[3] - rows[i];
+    }
+}
+
+// False only when the box is entirely behind one of the planes
+static bool isBoxVisible(const glm::vec4 planes[6], glm::vec3 low, glm::vec3 high){
+    for (int i = 0; i < 6; i++) {
+        glm::vec3 normal = glm::vec3(planes[i]);
+        glm::vec3 farthest = glm::vec3(normal.x >= 0.0f ? high.x : low.x,
+                                       normal.y >= 0.0f ? high.y : low.y,
+                                       normal.z >= 0.0f ? high.z : low.z);
+
+        if (glm::dot(normal, farthest) + planes[i].w < 0.0f) return false;
+    }
+
+    return true;
+}
+
+// Lists the draws of the chunks in the frustum of "viewProjection", to be
+// submitted by draw(), and returns the number of those chunks. Must be
+// called every frame after the uploads, as they can move meshes.
+long TerrainMeshes::cull(const glm::mat4& viewProjection){
+    glm::vec4 planes[6];
+    getFrustumPlanes(viewProjection, planes);
+
+    this->visible.clear();
+    this->commands.clear();
+    this->counts.clear();
+    this->offsets.clear();
+    this->baseVertices.clear();
+
+    // Faces are centered on the blocks, so chunks reach half a block back
+    for (auto& page : this->pages){
+        for (auto& entry : this->chunks){
+            const GpuChunk& chunk = entry.second;
+            if (chunk.page != page.get()) continue;
+
+            glm::vec3 low = glm::vec3(chunk.chunk * CHUNK_SIZE) - 0.5f;
+
+            if (isBoxVisible(planes, low, low + (float) CHUNK_SIZE)) this->visible.push_back(&chunk);
+        }
+    }
+
+    this->batches.clear();
+    this->triangles = 0;
+
+    // The visible chunks are in page order, so each page is one batch
+    for (const GpuChunk* chunk : this->visible){
+        GLuint vertexArrayId = chunk->page->vertexArrayId;
+
+        if (this->batches.empty() || this->batches.back().vertexArrayId != vertexArrayId){
+            this->batches.push_back({vertexArrayId, this->commands.size(), 0, 0});
+        }
+
+        this->commands.push_back({chunk->indexCount, 1, chunk->firstIndex, (GLint) chunk->firstVertex, 0});
+        this->counts.push_back(chunk->indexCount);
+        this->offsets.push_back((const void*) (chunk->firstIndex * sizeof(uint32_t)));
+        this->baseVertices.push_back(chunk->firstVertex);
+
+        this->batches.back().count++;
+        this->triangles += chunk->indexCount / 3;
+    }
+
+    this->indirect = GLEXT_ARB_multi_draw_indirect;
+    GLintptr offset = 0;
+
+    if (this->indirect && !this->commands.empty()){
+        this->indirect = this->indirectCommands.write(this->commands.data(), this->commands.size() * sizeof(DrawCommand),
+                                                      sizeof(DrawCommand), offset);
+    }
+
+    for (DrawBatch& batch : this->batches){
+        batch.indirectOffset = offset + batch.first * sizeof(DrawCommand);
+    }
+
+    return this->visible.size();
+}
+
+// Submits the draws cull() listed; the terrain textures must be bound.
+// Returns the number of submissions and adds the triangles to "triangles".
+long TerrainMeshes::draw(long& triangles){
+    long drawCalls = 0;
+
+    if (this->indirect) glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->indirectCommands.getId());
+
+    for (const DrawBatch& batch : this->batches){
+        glBindVertexArray(batch.vertexArrayId);
+
+        if (this->indirect){
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*) batch.indirectOffset, batch.count, 0);
+        } else {
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, &this->counts[batch.first], GL_UNSIGNED_INT,
+                                          &this->offsets[batch.first], batch.count, &this->baseVertices[batch.first]);
+        }
+
+        drawCalls++;
+    }
+
+    if (this->indirect) glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glBindVertexArray(0);
+    triangles += this->triangles;
+
+    return drawCalls;
+}
+
+// Once the draws of the frame are issued; ranges no frame in flight draws
+// any more are freed
+void TerrainMeshes::endFrame(){
+    this->staging.endFrame();
+    this->indirectCommands.endFrame();
+    this->frame++;
+
+    auto expired = std::partition(this->retired.begin(), this->retired.end(), [this](const RetiredRange& range){
+        return this->frame - range.frame < TERRAIN_FRAMES_IN_FLIGHT;
+    });
+
+    for (auto range = expired; range != this->retired.end(); range++){
+        range->page->vertices.free(range->firstVertex);
+        range->page->indices.free(range->firstIndex);
+        range->page->packed = false;
+    }
+
+    if (expired != this->retired.end()){
+        this->retired.erase(expired, this->retired.end());
+        releaseEmptyPages();
+    }
+}
+
+size_t TerrainMeshes::size(){
+    return this->chunks.size();
+}
+
+MeshMemoryStats TerrainMeshes::getMemoryStats(){
+    MeshMemoryStats stats;
+    size_t freeVertices = 0, freeIndices = 0;
+    size_t largestVertices = 0, largestIndices = 0;
+
+    stats.pages = this->pages.size();
+    stats.defragmentations = this->defragmentations;
+
+    for (auto& page : this->pages){
+        const BuddyStats& vertices = page->vertices.getStats();
+        const BuddyStats& indices = page->indices.getStats();
+
+        stats.usedBytes += vertices.requested * sizeof(TerrainVertex) + indices.requested * sizeof(uint32_t);
+        stats.allocatedBytes += vertices.allocated * sizeof(TerrainVertex) + indices.allocated * sizeof(uint32_t);
+        stats.capacityBytes += vertices.capacity * sizeof(TerrainVertex) + indices.capacity * sizeof(uint32_t);
+
+        freeVertices += vertices.getFree();
+        freeIndices += indices.getFree();
+        largestVertices = std::max(largestVertices, vertices.largestFree);
+        largestIndices = std::max(largestIndices, indices.largestFree);
+    }
+
+    double vertexFragmentation = freeVertices > 0 ? 1.0 - (double) largestVertices / freeVertices : 0.0;
+    double indexFragmentation = freeIndices > 0 ? 1.0 - (double) largestIndices / freeIndices : 0.0;
+
+    stats.fragmentation = std::max(vertexFragmentation, indexFragmentation);
+
+    return stats;
+}
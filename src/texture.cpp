@@ -1,6 +1,8 @@
 #include "texture.hpp"
 #include "stb_image.h"
 
+#include <algorithm>
+
 Texture::Texture(std::string file, GLenum target){
     this->target = target;
     this->file = file;
@@ -32,4 +34,63 @@ void Texture::load(){
 void Texture::bind(GLenum unit){
     glActiveTexture(unit);
     glBindTexture(this->target, this->object);
-}
\ No newline at end of file
+}
+
+ArrayTexture::ArrayTexture(std::vector<std::string> files){
+    this->files = files;
+}
+
+void ArrayTexture::load(){
+    stbi_set_flip_vertically_on_load(1);
+
+    std::vector<unsigned char*> images(this->files.size());
+    std::vector<int> widths(this->files.size()), heights(this->files.size());
+    int width = 1, height = 1;
+
+    for (size_t i = 0; i < this->files.size(); i++){
+        int bpp = 0;
+        images[i] = stbi_load(this->files[i].c_str(), &widths[i], &heights[i], &bpp, 4);
+
+        if (images[i] == NULL){
+            fprintf(stderr, "ERROR: Cannot load texture \"%s\".\n", this->files[i].c_str());
+            continue;
+        }
+
+        width = std::max(width, widths[i]);
+        height = std::max(height, heights[i]);
+    }
+
+    glGenTextures(1, &this->object);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->object);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width, height, this->files.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    // Nearest neighbour scaling, as the textures are sampled
+    std::vector<unsigned char> layer((size_t) width * height * 4);
+
+    for (size_t i = 0; i < this->files.size(); i++){
+        if (images[i] == NULL) continue;
+
+        for (int y = 0; y < height; y++){
+            for (int x = 0; x < width; x++){
+                const unsigned char* texel = images[i] + ((size_t) (y * heights[i] / height) * widths[i] + x * widths[i] / width) * 4;
+                std::copy(texel, texel + 4, &layer[((size_t) y * width + x) * 4]);
+            }
+        }
+
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, layer.data());
+        stbi_image_free(images[i]);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void ArrayTexture::bind(GLenum unit){
+    glActiveTexture(unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->object);
+}
@@ -0,0 +1,341 @@
+#include "voxel_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+// Faces closer than this count as touching, not overlapping, which absorbs
+// the rounding of boxes placed right against a face.
+#define FACE_EPSILON 1e-4f
+
+VoxelGrid::VoxelGrid(glm::ivec3 origin, glm::ivec3 size){
+    if (getLocalOf(origin) != glm::ivec3(0) || getLocalOf(size) != glm::ivec3(0)){
+        fprintf(stderr, "ERROR: The voxel grid must be made of whole chunks.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    this->origin = origin;
+    this->size = size;
+    this->chunkOrigin = getChunkOf(origin);
+    this->chunkCounts = size / CHUNK_SIZE;
+
+    size_t count = (size_t) this->chunkCounts.x * this->chunkCounts.y * this->chunkCounts.z;
+    this->chunks.resize(count);
+    this->dirty.assign(count, 0);
+}
+
+bool VoxelGrid::contains(glm::ivec3 block) const {
+    glm::ivec3 local = block - this->origin;
+
+    return local.x >= 0 && local.x < this->size.x &&
+           local.y >= 0 && local.y < this->size.y &&
+           local.z >= 0 && local.z < this->size.z;
+}
+
+bool VoxelGrid::containsChunk(glm::ivec3 chunk) const {
+    glm::ivec3 local = chunk - this->chunkOrigin;
+
+    return local.x >= 0 && local.x < this->chunkCounts.x &&
+           local.y >= 0 && local.y < this->chunkCounts.y &&
+           local.z >= 0 && local.z < this->chunkCounts.z;
+}
+
+size_t VoxelGrid::indexOfChunk(glm::ivec3 chunk) const {
+    glm::ivec3 local = chunk - this->chunkOrigin;
+
+    return ((size_t) local.x * this->chunkCounts.z + local.z) * this->chunkCounts.y + local.y;
+}
+
+void VoxelGrid::markDirty(glm::ivec3 chunk){
+    if (!containsChunk(chunk)) return;
+
+    uint8_t& flag = this->dirty[indexOfChunk(chunk)];
+
+    if (!flag) this->dirtyChunks.push_back(chunk);
+    flag = 1;
+}
+
+// Marks every chunk within MESH_MARGIN blocks of the box of blocks from
+// "min" to "max"
+void VoxelGrid::markDirtyAround(glm::ivec3 min, glm::ivec3 max){
+    glm::ivec3 first = getChunkOf(min - glm::ivec3(MESH_MARGIN));
+    glm::ivec3 last = getChunkOf(max + glm::ivec3(MESH_MARGIN));
+    glm::ivec3 chunk;
+
+    for (chunk.x = first.x; chunk.x <= last.x; chunk.x++) {
+        for (chunk.z = first.z; chunk.z <= last.z; chunk.z++) {
+            for (chunk.y = first.y; chunk.y <= last.y; chunk.y++) markDirty(chunk);
+        }
+    }
+}
+
+Block VoxelGrid::getBlock(glm::ivec3 block) const {
+    if (!contains(block)) return air;
+
+    const Chunk* chunk = this->chunks[indexOfChunk(getChunkOf(block))].get();
+
+    return chunk != NULL ? chunk->get(getLocalOf(block)) : (Block) air;
+}
+
+void VoxelGrid::setBlock(glm::ivec3 block, Block type){
+    if (!contains(block)) return;
+
+    glm::ivec3 chunkCoords = getChunkOf(block);
+    glm::ivec3 local = getLocalOf(block);
+    std::unique_ptr<Chunk>& chunk = this->chunks[indexOfChunk(chunkCoords)];
+
+    if (chunk == NULL){
+        if (type == air) return;
+        chunk.reset(new Chunk());
+    }
+
+    if (chunk->get(local) == type) return;
+
+    chunk->set(local, type);
+    if (chunk->isEmpty()) chunk.reset();
+
+    markDirty(chunkCoords);
+
+    markDirtyAround(block, block);
+}
+
+// Swaps all the blocks of a chunk at once, NULL meaning only air. The chunk
+// is marked dirty with everything around it.
+void VoxelGrid::replaceChunk(glm::ivec3 chunk, std::unique_ptr<Chunk> blocks){
+    if (!containsChunk(chunk)) return;
+
+    if (blocks != NULL && blocks->isEmpty()) blocks.reset();
+    this->chunks[indexOfChunk(chunk)] = std::move(blocks);
+
+    glm::ivec3 min = chunk * CHUNK_SIZE;
+    glm::ivec3 max = min + glm::ivec3(CHUNK_SIZE - 1);
+
+    markDirty(chunk);
+    markDirtyAround(min, max);
+}
+
+bool VoxelGrid::isSolid(glm::ivec3 block) const {
+    return getBlock(block) != air;
+}
+
+// NULL when the chunk holds only air
+const Chunk* VoxelGrid::getChunk(glm::ivec3 chunk) const {
+    return containsChunk(chunk) ? this->chunks[indexOfChunk(chunk)].get() : NULL;
+}
+
+// Coordinates of every chunk of the grid, empty or not, layer by layer
+void VoxelGrid::listChunks(std::vector<glm::ivec3>& chunks) const {
+    chunks.clear();
+
+    glm::ivec3 chunk;
+
+    for (chunk.y = this->chunkOrigin.y; chunk.y < this->chunkOrigin.y + this->chunkCounts.y; chunk.y++) {
+        for (chunk.z = this->chunkOrigin.z; chunk.z < this->chunkOrigin.z + this->chunkCounts.z; chunk.z++) {
+            for (chunk.x = this->chunkOrigin.x; chunk.x < this->chunkOrigin.x + this->chunkCounts.x; chunk.x++) {
+                chunks.push_back(chunk);
+            }
+        }
+    }
+}
+
+// Moves the chunks changed since the last call to "taken", in the order they
+// were first changed
+void VoxelGrid::takeDirtyChunks(std::vector<glm::ivec3>& taken){
+    taken.clear();
+    taken.swap(this->dirtyChunks);
+
+    for (glm::ivec3 chunk : taken) this->dirty[indexOfChunk(chunk)] = 0;
+}
+
+// Bytes used by the chunks and their bookkeeping
+size_t VoxelGrid::getMemoryUsage() const {
+    size_t bytes = this->chunks.capacity() * sizeof(std::unique_ptr<Chunk>) + this->dirty.capacity();
+
+    for (const std::unique_ptr<Chunk>& chunk : this->chunks) {
+        if (chunk != NULL) bytes += chunk->getMemoryUsage();
+    }
+
+    return bytes;
+}
+
+glm::ivec3 VoxelGrid::getOrigin() const {
+    return this->origin;
+}
+
+glm::ivec3 VoxelGrid::getSize() const {
+    return this->size;
+}
+
+// Whether any block of the layer "layer" along "axis" is solid between
+// "from" and "to", included, on the two other axes.
+static bool isLayerSolid(const VoxelGrid& grid, int axis, int layer, glm::ivec3 from, glm::ivec3 to){
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+
+    glm::ivec3 block;
+    block[axis] = layer;
+
+    for (block[u] = from[u]; block[u] <= to[u]; block[u]++) {
+        for (block[v] = from[v]; block[v] <= to[v]; block[v]++) {
+            if (grid.isSolid(block)) return true;
+        }
+    }
+
+    return false;
+}
+
+SweepResult sweepAabb(const VoxelGrid& grid, const Aabb& box, glm::vec3 displacement){
+    // Block b spans [b - 0.5, b + 0.5]; shifted by half a block it spans
+    // [b, b + 1), so floor() and ceil() give block coordinates directly.
+    glm::vec3 low = box.min + 0.5f;
+    glm::vec3 high = box.max + 0.5f;
+
+    glm::ivec3 gridLow = grid.getOrigin();
+    glm::ivec3 gridHigh = gridLow + grid.getSize() - 1;
+
+    SweepResult result = {glm::vec3(0.0f), glm::bvec3(false)};
+    static const int axes[3] = {1, 0, 2};
+
+    for (int axis : axes) {
+        float d = displacement[axis];
+        if (d == 0.0f) continue;
+
+        // Blocks overlapped on the other two axes, touching faces excluded
+        glm::ivec3 from = glm::max(glm::ivec3(glm::floor(low + FACE_EPSILON)), gridLow);
+        glm::ivec3 to = glm::min(glm::ivec3(glm::ceil(high - FACE_EPSILON)) - 1, gridHigh);
+
+        if (d > 0.0f) {
+            // Layers starting at or past the leading face, up to where it ends
+            int first = std::max((int) ceil(high[axis] - FACE_EPSILON), gridLow[axis]);
+            int last = std::min((int) ceil(high[axis] + d) - 1, gridHigh[axis]);
+
+            for (int layer = first; layer <= last; layer++) {
+                if (isLayerSolid(grid, axis, layer, from, to)) {
+                    d = std::min(d, layer - high[axis]);
+                    result.hit[axis] = true;
+                    break;
+                }
+            }
+        } else {
+            int first = std::min((int) floor(low[axis] + FACE_EPSILON) - 1, gridHigh[axis]);
+            int last = std::max((int) floor(low[axis] + d), gridLow[axis]);
+
+            for (int layer = first; layer >= last; layer--) {
+                if (isLayerSolid(grid, axis, layer, from, to)) {
+                    d = std::max(d, layer + 1 - low[axis]);
+                    result.hit[axis] = true;
+                    break;
+                }
+            }
+        }
+
+        low[axis] += d;
+        high[axis] += d;
+        result.displacement[axis] = d;
+    }
+
+    return result;
+}
+
+RaycastHit raycast(const VoxelGrid& grid, glm::vec3 origin, glm::vec3 direction, float maxDistance){
+    RaycastHit result = {false, glm::ivec3(0), glm::ivec3(0), 0.0f};
+
+    float length = glm::length(direction);
+    if (length == 0.0f) return result;
+
+    direction /= length;
+
+    // Same half block shift as sweepAabb(): block b spans [b, b + 1)
+    glm::vec3 start = origin + 0.5f;
+    glm::ivec3 gridLow = grid.getOrigin();
+    glm::ivec3 gridHigh = gridLow + grid.getSize();
+
+    const float infinity = std::numeric_limits<float>::infinity();
+
+    // Slab test against the box of the whole grid
+    float enter = 0.0f;
+    float exit = maxDistance;
+    int enterAxis = -1;
+
+    for (int axis = 0; axis < 3; axis++) {
+        if (direction[axis] == 0.0f) {
+            if (start[axis] < gridLow[axis] || start[axis] >= gridHigh[axis]) return result;
+            continue;
+        }
+
+        float inverse = 1.0f / direction[axis];
+        float near = (gridLow[axis] - start[axis]) * inverse;
+        float far = (gridHigh[axis] - start[axis]) * inverse;
+        if (near > far) std::swap(near, far);
+
+        if (near > enter) {
+            enter = near;
+            enterAxis = axis;
+        }
+        exit = std::min(exit, far);
+    }
+
+    if (enter > exit) return result;
+
+    glm::vec3 point = start + direction * enter;
+    glm::ivec3 block = glm::clamp(glm::ivec3(glm::floor(point)), gridLow, gridHigh - 1);
+
+    glm::ivec3 step;
+    glm::vec3 delta;
+    glm::vec3 next;
+
+    for (int axis = 0; axis < 3; axis++) {
+        step[axis] = direction[axis] > 0.0f ? 1 : (direction[axis] < 0.0f ? -1 : 0);
+
+        if (step[axis] == 0) {
+            delta[axis] = infinity;
+            next[axis] = infinity;
+            continue;
+        }
+
+        // Distance along the ray to cross one block, and to the next face
+        delta[axis] = fabsf(1.0f / direction[axis]);
+        float face = step[axis] > 0 ? block[axis] + 1.0f : (float) block[axis];
+        next[axis] = enter + (face - point[axis]) / direction[axis];
+    }
+
+    glm::ivec3 normal = glm::ivec3(0);
+    if (enterAxis >= 0) normal[enterAxis] = -step[enterAxis];
+
+    float distance = enter;
+
+    while (true) {
+        if (grid.isSolid(block)) {
+            result.hit = true;
+            result.block = block;
+            result.normal = normal;
+            result.distance = distance;
+            return result;
+        }
+
+        int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+
+        distance = next[axis];
+        if (distance > exit) return result;
+
+        block[axis] += step[axis];
+        next[axis] += delta[axis];
+        normal = glm::ivec3(0);
+        normal[axis] = -step[axis];
+
+        if (block[axis] < gridLow[axis] || block[axis] >= gridHigh[axis]) return result;
+    }
+}
+
+void raycastBatch(const VoxelGrid& grid, const glm::vec3* origins, const glm::vec3* directions, size_t count,
+                  float maxDistance, RaycastHit* hits){
+    for (size_t i = 0; i < count; i++) hits[i] = raycast(grid, origins[i], directions[i], maxDistance);
+}
+
+bool hasLineOfSight(const VoxelGrid& grid, glm::vec3 from, glm::vec3 to){
+    glm::vec3 direction = to - from;
+
+    return !raycast(grid, from, direction, glm::length(direction)).hit;
+}
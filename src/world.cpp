@@ -0,0 +1,456 @@
+#include "world.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include "collisions.hpp"
+#include "globals.hpp"
+#include "std/matrices.h"
+
+// Seconds the leaf takes to go through its curve
+#define LEAF_PERIOD 10.0f
+
+// Cows fall with this acceleration, up to FALL_SPEED
+#define GRAVITY 30.0f
+#define FALL_SPEED 5.0f
+
+// Vertical extent of the voxel grid, in blocks, a multiple of CHUNK_SIZE
+#define WORLD_BOTTOM -48
+#define WORLD_HEIGHT 64
+
+// How far away blocks can be picked
+#define PICK_DISTANCE 8.0f
+
+// Light level of the torches placed by the player
+#define TORCH_LIGHT 14
+
+// Seconds of simulation between two saves of the edited chunks
+#define AUTOSAVE_INTERVAL 30.0
+
+// Chunks ahead of the moving camera read ahead from the region files
+#define READAHEAD_CHUNKS 3
+
+// Entities below this height fell off the map and are destroyed
+#define KILL_HEIGHT -100.0f
+
+// Moving more than this in one tick is a teleport, which is not interpolated
+#define TELEPORT_DISTANCE 2.0f
+
+static const Collider cowCollider = {1.5f, glm::vec3(0.5f, 1.0f, 0.5f)};
+static const Collider noCollider = {0.0f, glm::vec3(0.0f)};
+
+World::World(unsigned int seed, Profiler& profiler, GenerationCache* generationCache) :
+    voxels(glm::ivec3(-MAP_SIZE / 2, WORLD_BOTTOM, -MAP_SIZE / 2), glm::ivec3(MAP_SIZE, WORLD_HEIGHT, MAP_SIZE)),
+    lights(voxels),
+    generator(seed),
+    profiler(profiler){
+    this->seed = seed;
+
+    generateTerrain(generationCache);
+    this->lights.relightAll();
+
+    // Surface of every column, used by the benchmarks
+    int init = -MAP_SIZE / 2;
+
+    for (int i = 0; i < MAP_SIZE; ++i) {
+        for (int j = 0; j < MAP_SIZE; ++j) {
+            mapData[i][j] = glm::vec4(init + i, this->generator.getHeight(init + i, init + j), init + j, 1.0f);
+        }
+    }
+
+    this->cow = this->entities.create(cowMesh, glm::vec3(-2.0f, 0.0f, -2.0f), 0.0f, glm::vec3(0.0f, -FALL_SPEED, 0.0f), cowCollider);
+    this->leaf = this->entities.create(leafMesh, glm::vec3(0.0f), 0.0f, glm::vec3(0.0f), noCollider);
+
+    addPathFollower(this->leaf, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f), glm::vec4(10.0f, -4.0f, 0.0f, 0.0f),
+                    glm::vec4(-10.0f, -6.0f, 0.0f, 0.0f), glm::vec4(0.0f, -10.0f, 0.0f, 0.0f), LEAF_PERIOD);
+
+    this->cameraPhase = profiler.addPhase("camera", false);
+    this->entitiesPhase = profiler.addPhase("entities", false);
+    this->collisionPhase = profiler.addPhase("collision", false);
+    this->lightingPhase = profiler.addPhase("lighting", false);
+    this->meshingPhase = profiler.addPhase("meshing", false);
+
+    remeshChunks();
+
+    captureState(this->currentState);
+    this->previousState = this->currentState;
+}
+
+// Every chunk of the grid, from the cache when it has them, the rest at
+// once on worker threads
+void World::generateTerrain(GenerationCache* generationCache){
+    std::vector<glm::ivec3> chunks;
+    std::vector<glm::ivec3> missing;
+    this->voxels.listChunks(chunks);
+
+    for (glm::ivec3 chunk : chunks) {
+        std::unique_ptr<Chunk> blocks;
+
+        if (generationCache != NULL && generationCache->find(this->seed, chunk, blocks)) {
+            this->voxels.replaceChunk(chunk, std::move(blocks));
+        } else {
+            missing.push_back(chunk);
+        }
+    }
+
+    std::vector<std::unique_ptr<Chunk>> generated;
+    generateChunks(this->generator, missing, generated, this->generationTimings);
+
+    for (size_t i = 0; i < missing.size(); i++) {
+        if (generationCache != NULL) generationCache->insert(this->seed, missing[i], generated[i].get());
+
+        this->voxels.replaceChunk(missing[i], std::move(generated[i]));
+    }
+}
+
+// Drops "count" more cows at random places over the map
+void World::spawnHerd(int count){
+    std::mt19937 random(this->seed);
+    std::uniform_real_distribution<float> horizontal(-MAP_SIZE / 2.0f, MAP_SIZE / 2.0f);
+    std::uniform_real_distribution<float> height(0.0f, 20.0f);
+    std::uniform_real_distribution<float> rotation(0.0f, 2.0f * 3.141592f);
+
+    this->entities.reserve(this->entities.size() + count);
+
+    for (int i = 0; i < count; i++) {
+        glm::vec3 position = glm::vec3(horizontal(random), height(random), horizontal(random));
+
+        this->entities.create(cowMesh, position, rotation(random), glm::vec3(0.0f, -FALL_SPEED, 0.0f), cowCollider);
+    }
+
+    captureState(this->currentState);
+    this->previousState = this->currentState;
+}
+
+// Moves "entity" along a curve shaped as BezierCurve::calculate() makes it,
+// at the constant speed that takes "period" seconds from start to end, then
+// starts over.
+void World::addPathFollower(EntityId entity, glm::vec4 p0, glm::vec4 p1, glm::vec4 c0, glm::vec4 c1, float period){
+    this->paths.add(p0, p1, c0, c1);
+
+    this->pathEntities.push_back(entity);
+    this->pathProgress.push_back(0.0f);
+    this->pathSpeeds.push_back(1.0f / period);
+
+    size_t count = this->paths.size();
+    this->pathParameters.resize(count);
+    this->pathX.resize(count);
+    this->pathY.resize(count);
+    this->pathZ.resize(count);
+
+    updatePaths();
+}
+
+// All the curves in one pass, then the points go to their entities
+void World::updatePaths(){
+    this->paths.getParametersAtDistance(this->pathProgress.data(), this->pathParameters.data());
+    this->paths.evaluate(this->pathParameters.data(), this->pathX.data(), this->pathY.data(), this->pathZ.data());
+
+    for (size_t i = 0; i < this->pathEntities.size(); i++) {
+        EntityId entity = this->pathEntities[i];
+
+        if (this->entities.isAlive(entity)) {
+            this->entities.positions[this->entities.indexOf(entity)] = glm::vec3(this->pathX[i], this->pathY[i], this->pathZ[i]);
+        }
+    }
+}
+
+// Copies into "state", reusing the memory of its arrays
+void World::captureState(WorldState& state){
+    // Refreshes the view vectors of the camera
+    camera.getView();
+
+    state.cameraFree = camera.getIsFree();
+    state.cameraPosition = camera.getPosition();
+    state.cameraDirection = camera.getDirection();
+
+    state.entityIds = this->entities.getIds();
+    state.entityPositions = this->entities.positions;
+    state.entityRotations = this->entities.rotations;
+    state.entityMeshes = this->entities.meshes;
+}
+
+void World::applyCommands(){
+    inputCommands.drain(this->commands);
+
+    for (const Command& command : this->commands){
+        switch(command.type){
+            case(moveCamera): camera.setUpdatingPosition(command.direction); break;
+            case(rotateCamera): camera.updateMouse(command.dx, command.dy); break;
+            case(zoomCamera): camera.updateDistance(command.dy); break;
+            case(changeCameraMode): camera.changeMode(); break;
+            case(rotateCow):
+                if (this->entities.isAlive(this->cow)) this->entities.rotations[this->entities.indexOf(this->cow)] += command.dy;
+                break;
+            case(breakBlock):
+                pick();
+                if (this->pickedBlock.hit) setBlock(this->pickedBlock.block, air);
+                break;
+            case(placeBlock):
+                pick();
+                if (this->pickedBlock.hit && this->pickedBlock.normal != glm::ivec3(0)) {
+                    setBlock(this->pickedBlock.block + this->pickedBlock.normal, dirt);
+                }
+                break;
+            case(toggleTorch):
+                pick();
+                if (this->pickedBlock.hit && this->pickedBlock.normal != glm::ivec3(0)) {
+                    glm::ivec3 torch = this->pickedBlock.block + this->pickedBlock.normal;
+
+                    if (this->lights.isSource(torch)) this->lights.removeSource(torch);
+                    else this->lights.addSource(torch, TORCH_LIGHT);
+                }
+                break;
+        }
+    }
+}
+
+// Casts a ray from the eye of the camera, straight ahead
+void World::pick(){
+    camera.getView();
+
+    this->pickedBlock = raycast(this->voxels, glm::vec3(camera.getPosition()), glm::vec3(camera.getDirection()), PICK_DISTANCE);
+}
+
+// Edits are only stored here, they reach the renderer at the end of the tick
+void World::setBlock(glm::ivec3 block, Block type){
+    if (!this->edited) {
+        this->edited = true;
+        this->firstEditTime = std::chrono::steady_clock::now();
+    }
+
+    this->voxels.setBlock(block, type);
+    this->lights.blockChanged(block);
+
+    glm::ivec3 chunk = getChunkOf(block);
+    this->unsavedChunks[getChunkKey(chunk)] = chunk;
+}
+
+// Asks for every chunk of the grid; the ones ever saved replace the
+// generated terrain in the next ticks, as they are read
+void World::attachStorage(WorldStorage& storage){
+    this->storage = &storage;
+
+    std::vector<glm::ivec3> chunks;
+    this->voxels.listChunks(chunks);
+
+    for (glm::ivec3 chunk : chunks) storage.requestLoad(chunk);
+}
+
+// Chunks edited before they were read keep the edits
+void World::loadChunks(){
+    if (this->storage == NULL) return;
+
+    this->storage->takeLoaded(this->loadedChunks);
+
+    for (StoredChunk& stored : this->loadedChunks) {
+        if (this->unsavedChunks.count(getChunkKey(stored.chunk))) continue;
+
+        this->voxels.replaceChunk(stored.chunk, std::move(stored.blocks));
+        this->lights.chunkReplaced(stored.chunk);
+    }
+}
+
+// Whenever the camera enters another chunk, the next chunks along its
+// movement are hinted to the storage
+void World::adviseChunks(){
+    if (this->storage == NULL) return;
+
+    camera.getView();
+
+    glm::vec3 position = glm::vec3(camera.getPosition());
+    glm::vec3 movement = position - glm::vec3(this->previousState.cameraPosition);
+    glm::ivec3 chunk = getChunkOf(glm::ivec3(glm::round(position)));
+
+    if (chunk == this->cameraChunk || glm::dot(movement, movement) == 0.0f) return;
+
+    this->cameraChunk = chunk;
+    glm::vec3 direction = glm::normalize(movement);
+
+    for (int i = 1; i <= READAHEAD_CHUNKS; i++) {
+        glm::vec3 ahead = position + direction * (float) (i * CHUNK_SIZE);
+
+        this->storage->requestAdvise(getChunkOf(glm::ivec3(glm::round(ahead))));
+    }
+}
+
+// Only queues the writes, the storage does them in the background. Called
+// from tick(), or while the simulation is stopped.
+void World::save(){
+    if (this->storage == NULL) return;
+
+    for (const auto& entry : this->unsavedChunks) {
+        this->storage->requestSave(entry.second, this->voxels.getChunk(entry.second));
+    }
+
+    this->unsavedChunks.clear();
+    this->lastSaveTime = this->time;
+}
+
+// Meshes only the chunks touched since the last call, so an edit costs the
+// few chunks it can be seen or lit in, never the whole terrain
+void World::remeshChunks(){
+    this->voxels.takeDirtyChunks(this->dirtyChunks);
+    meshChunks(this->voxels, this->lights, this->dirtyChunks, this->meshers, this->dirtyMeshes);
+
+    // One latency sample per batch of edits, however many chunks it touched:
+    // only the last mesh of the batch carries it, as the edits are all
+    // visible once that one is
+    for (size_t i = 0; i < this->dirtyMeshes.size(); i++) {
+        ChunkMesh& mesh = this->dirtyMeshes[i];
+        mesh.edited = this->edited && i + 1 == this->dirtyMeshes.size();
+        mesh.editTime = this->firstEditTime;
+
+        this->chunkMeshes.push(std::move(mesh));
+    }
+
+    this->edited = false;
+}
+
+ChunkMeshQueue& World::getChunkMeshes(){
+    return this->chunkMeshes;
+}
+
+void World::updateCamera(double deltaTime){
+    camera.move(deltaTime);
+}
+
+void World::updateEntities(double deltaTime){
+    applyGravity(this->entities, GRAVITY, FALL_SPEED, deltaTime);
+    moveEntities(this->entities, this->voxels, deltaTime);
+    destroyEntitiesBelow(this->entities, KILL_HEIGHT);
+}
+
+void World::updateCollisions(){
+    this->broadphase.build(this->entities);
+
+    camera.collide(this->voxels, this->entities, this->broadphase);
+
+    this->candidatePairs.clear();
+    this->broadphase.findPairs(this->candidatePairs);
+    separateEntities(this->entities, this->candidatePairs);
+}
+
+void World::updateAnimations(double deltaTime){
+    for (size_t i = 0; i < this->pathProgress.size(); i++) {
+        this->pathProgress[i] += this->pathSpeeds[i] * deltaTime;
+
+        if (this->pathProgress[i] > 1.0f) this->pathProgress[i] = 0.0f;
+    }
+
+    updatePaths();
+}
+
+// Advances the simulation by exactly SIMULATION_STEP seconds
+void World::tick(){
+    std::swap(this->previousState, this->currentState);
+    this->time += SIMULATION_STEP;
+
+    loadChunks();
+    applyCommands();
+
+    {
+        ScopedTimer timer(this->profiler, this->cameraPhase);
+        updateCamera(SIMULATION_STEP);
+    }
+
+    adviseChunks();
+
+    {
+        ScopedTimer timer(this->profiler, this->entitiesPhase);
+        updateEntities(SIMULATION_STEP);
+    }
+
+    {
+        ScopedTimer timer(this->profiler, this->collisionPhase);
+        updateCollisions();
+    }
+
+    updateAnimations(SIMULATION_STEP);
+
+    {
+        ScopedTimer timer(this->profiler, this->lightingPhase);
+        this->lights.propagate();
+    }
+
+    {
+        ScopedTimer timer(this->profiler, this->meshingPhase);
+        remeshChunks();
+    }
+
+    if (this->time - this->lastSaveTime >= AUTOSAVE_INTERVAL) save();
+
+    captureState(this->currentState);
+}
+
+double World::getTime(){
+    return this->time;
+}
+
+size_t World::getEntityCount(){
+    return this->entities.size();
+}
+
+const GeneratorTimings& World::getGenerationTimings(){
+    return this->generationTimings;
+}
+
+size_t World::getBlockMemory(){
+    return this->voxels.getMemoryUsage();
+}
+
+// The block targeted by the last breakBlock or placeBlock command, if any
+RaycastHit World::getPickedBlock(){
+    return this->pickedBlock;
+}
+
+WorldState World::getState(float alpha){
+    return interpolateStates(this->previousState, this->currentState, alpha);
+}
+
+const WorldState& World::getPreviousState(){
+    return this->previousState;
+}
+
+const WorldState& World::getCurrentState(){
+    return this->currentState;
+}
+
+WorldState interpolateStates(const WorldState& previous, const WorldState& current, float alpha){
+    WorldState state = current;
+
+    // Switching the camera mode cuts instead of flying between the two
+    if (current.cameraFree == previous.cameraFree) {
+        state.cameraPosition = glm::mix(previous.cameraPosition, current.cameraPosition, alpha);
+        state.cameraDirection = glm::mix(previous.cameraDirection, current.cameraDirection, alpha);
+    }
+
+    // Only entities at the same index in both ticks are blended; the few
+    // moved around by a destroy() are drawn where they are now.
+    size_t count = std::min(previous.entityIds.size(), current.entityIds.size());
+
+    for (size_t i = 0; i < count; i++) {
+        if (previous.entityIds[i] != current.entityIds[i]) continue;
+
+        const glm::vec3& from = previous.entityPositions[i];
+        const glm::vec3& to = current.entityPositions[i];
+
+        // The leaf jumps back to the start of its curve instead of sweeping it
+        if (glm::distance(from, to) > TELEPORT_DISTANCE) continue;
+
+        state.entityPositions[i] = glm::mix(from, to, alpha);
+        state.entityRotations[i] = glm::mix(previous.entityRotations[i], current.entityRotations[i], alpha);
+    }
+
+    return state;
+}
+
+glm::mat4 WorldState::getView() const {
+    return Matrix_Camera_View(this->cameraPosition, this->cameraDirection, glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
+}
+
+glm::mat4 WorldState::getEntityModel(size_t index) const {
+    const glm::vec3& position = this->entityPositions[index];
+
+    return Matrix_Translate(position.x, position.y, position.z) * Matrix_Rotate_Y(this->entityRotations[index]);
+}
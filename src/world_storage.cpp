@@ -0,0 +1,227 @@
+#include "world_storage.hpp"
+
+#include <cstdio>
+#include <filesystem>
+
+#include <zlib.h>
+
+void encodeChunk(const Chunk* blocks, std::vector<uint8_t>& payload){
+    static const Chunk emptyChunk;
+
+    std::vector<uint8_t> serialized;
+    (blocks != NULL ? blocks : &emptyChunk)->serialize(serialized);
+
+    uLongf compressedLength = compressBound(serialized.size());
+    payload.resize(4 + compressedLength);
+
+    payload[0] = serialized.size() & 0xff;
+    payload[1] = (serialized.size() >> 8) & 0xff;
+    payload[2] = (serialized.size() >> 16) & 0xff;
+    payload[3] = (serialized.size() >> 24) & 0xff;
+
+    compress2(&payload[4], &compressedLength, serialized.data(), serialized.size(), Z_DEFAULT_COMPRESSION);
+    payload.resize(4 + compressedLength);
+}
+
+// Inflates straight from "payload", which may point into a mapped file,
+// without copying it first
+bool decodeChunk(const uint8_t* payload, size_t size, std::unique_ptr<Chunk>& blocks){
+    if (size < 4) return false;
+
+    uLongf length = payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((uLongf) payload[3] << 24);
+
+    uint8_t serialized[CHUNK_MAX_SERIALIZED_SIZE];
+    if (length > sizeof(serialized)) return false;
+
+    uLongf decompressedLength = length;
+
+    if (uncompress(serialized, &decompressedLength, payload + 4, size - 4) != Z_OK ||
+        decompressedLength != length) return false;
+
+    std::unique_ptr<Chunk> chunk(new Chunk());
+    if (!chunk->deserialize(serialized, length)) return false;
+
+    if (chunk->isEmpty()) chunk.reset();
+    blocks = std::move(chunk);
+
+    return true;
+}
+
+WorldStorage::WorldStorage(const char* directory){
+    this->directory = directory;
+
+    std::error_code error;
+    std::filesystem::create_directories(this->directory, error);
+
+    if (error) fprintf(stderr, "ERROR: Cannot create world directory \"%s\".\n", directory);
+
+    this->thread = std::thread(&WorldStorage::run, this);
+}
+
+WorldStorage::~WorldStorage(){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+
+    this->wake.notify_one();
+    this->thread.join();
+}
+
+// False if the world was never saved
+bool WorldStorage::readSeed(unsigned int& seed){
+    FILE* file = fopen((this->directory + "/world.txt").c_str(), "r");
+    if (file == NULL) return false;
+
+    bool read = fscanf(file, "seed %u", &seed) == 1;
+    fclose(file);
+
+    return read;
+}
+
+bool WorldStorage::writeSeed(unsigned int seed){
+    std::string filename = this->directory + "/world.txt";
+    FILE* file = fopen(filename.c_str(), "w");
+
+    if (file == NULL){
+        fprintf(stderr, "ERROR: Cannot write file \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    fprintf(file, "seed %u\n", seed);
+    fclose(file);
+
+    return true;
+}
+
+void WorldStorage::requestLoad(glm::ivec3 chunk){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->requests.push_back({loadChunk, chunk, NULL});
+    }
+
+    this->wake.notify_one();
+}
+
+// Copies the blocks, so the chunk may change right after
+void WorldStorage::requestSave(glm::ivec3 chunk, const Chunk* blocks){
+    std::unique_ptr<Chunk> copy(blocks != NULL ? new Chunk(*blocks) : NULL);
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->requests.push_back({saveChunk, chunk, std::move(copy)});
+    }
+
+    this->wake.notify_one();
+}
+
+// Hints that the chunk will be loaded soon, so its pages are read ahead.
+// Hints skip the queue: they are cheap, and useless once the load is done.
+void WorldStorage::requestAdvise(glm::ivec3 chunk){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->requests.push_front({adviseChunk, chunk, NULL});
+    }
+
+    this->wake.notify_one();
+}
+
+// Moves the chunks loaded since the last call to "taken". Chunks that were
+// never saved are not reported.
+void WorldStorage::takeLoaded(std::vector<StoredChunk>& taken){
+    taken.clear();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    taken.swap(this->loaded);
+}
+
+// Waits until every request made so far is done
+void WorldStorage::flush(){
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    this->idle.wait(lock, [this]{ return this->requests.empty() && !this->busy; });
+}
+
+// Opens region files on first use, creating them only if "create" is set;
+// NULL if there is no usable file
+RegionFile* WorldStorage::getRegion(glm::ivec3 chunk, bool create){
+    glm::ivec3 region = RegionFile::getRegionOf(chunk);
+    std::unique_ptr<RegionFile>& file = this->regions[getChunkKey(region)];
+
+    if (file == NULL){
+        char name[64];
+        snprintf(name, sizeof(name), "/r.%d.%d.%d.mglr", region.x, region.y, region.z);
+        std::string filename = this->directory + name;
+
+        if (!create && !std::filesystem::exists(filename)) return NULL;
+
+        file.reset(new RegionFile());
+        if (!file->open(filename)) file.reset(new RegionFile());
+    }
+
+    return file->isOpen() ? file.get() : NULL;
+}
+
+void WorldStorage::load(Request& request){
+    RegionFile* region = getRegion(request.chunk, false);
+    if (region == NULL) return;
+
+    size_t length;
+    const uint8_t* payload = region->view(RegionFile::getLocalOf(request.chunk), length);
+    if (payload == NULL) return;
+
+    StoredChunk stored;
+    stored.chunk = request.chunk;
+
+    if (!decodeChunk(payload, length, stored.blocks)){
+        fprintf(stderr, "ERROR: Chunk (%d, %d, %d) is corrupted.\n", request.chunk.x, request.chunk.y, request.chunk.z);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->loaded.push_back(std::move(stored));
+}
+
+void WorldStorage::save(Request& request){
+    RegionFile* region = getRegion(request.chunk, true);
+    if (region == NULL) return;
+
+    std::vector<uint8_t> payload;
+    encodeChunk(request.blocks.get(), payload);
+
+    region->write(RegionFile::getLocalOf(request.chunk), payload);
+}
+
+void WorldStorage::advise(Request& request){
+    RegionFile* region = getRegion(request.chunk, false);
+
+    if (region != NULL) region->advise(RegionFile::getLocalOf(request.chunk));
+}
+
+void WorldStorage::run(){
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (true) {
+        this->wake.wait(lock, [this]{ return this->stopping || !this->requests.empty(); });
+
+        // Pending requests are finished before stopping
+        if (this->requests.empty()) break;
+
+        Request request = std::move(this->requests.front());
+        this->requests.pop_front();
+        this->busy = true;
+
+        lock.unlock();
+
+        switch(request.type){
+            case(loadChunk): load(request); break;
+            case(saveChunk): save(request); break;
+            case(adviseChunk): advise(request); break;
+        }
+
+        lock.lock();
+        this->busy = false;
+
+        if (this->requests.empty()) this->idle.notify_all();
+    }
+}
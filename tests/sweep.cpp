@@ -0,0 +1,191 @@
+// Tests of sweepAabb(), the collision solver moving the camera and the
+// entities through the voxel grid. Needs neither a window nor an OpenGL
+// context. Every check prints its name and result; the exit status is
+// non-zero when any of them fails.
+//
+// Usage: MineGLTests
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "voxel_grid.hpp"
+
+#define TEST_SEED 1234
+
+// Boxes closer than this to a face count as touching it
+#define TOLERANCE 1e-3f
+
+static int failures = 0;
+
+static void check(const char* name, bool passed){
+    printf("%s %s\n", passed ? "PASS" : "FAIL", name);
+
+    if (!passed) failures++;
+}
+
+// Grid of 64x128x64 blocks whose surface, the top of the blocks at y = -1, is
+// at y = -0.5
+static void buildFloor(VoxelGrid& grid){
+    glm::ivec3 origin = grid.getOrigin();
+    glm::ivec3 size = grid.getSize();
+    glm::ivec3 block;
+
+    for (block.y = origin.y; block.y < 0; block.y++) {
+        for (block.z = origin.z; block.z < origin.z + size.z; block.z++) {
+            for (block.x = origin.x; block.x < origin.x + size.x; block.x++) grid.setBlock(block, stone);
+        }
+    }
+}
+
+static VoxelGrid makeGrid(){
+    return VoxelGrid(glm::ivec3(-32, -64, -32), glm::ivec3(64, 128, 64));
+}
+
+// Box of the camera body, standing on "feet"
+static Aabb bodyAt(glm::vec3 feet){
+    return {feet - glm::vec3(0.3f, 0.0f, 0.3f), feet + glm::vec3(0.3f, 1.7f, 0.3f)};
+}
+
+// Whether the box overlaps a solid block by more than "tolerance"
+static bool penetrates(const VoxelGrid& grid, const Aabb& box, float tolerance){
+    glm::vec3 low = box.min + 0.5f + tolerance;
+    glm::vec3 high = box.max + 0.5f - tolerance;
+    glm::ivec3 from = glm::ivec3(glm::floor(low));
+    glm::ivec3 to = glm::ivec3(glm::ceil(high)) - 1;
+    glm::ivec3 block;
+
+    for (block.y = from.y; block.y <= to.y; block.y++) {
+        for (block.z = from.z; block.z <= to.z; block.z++) {
+            for (block.x = from.x; block.x <= to.x; block.x++) {
+                if (grid.isSolid(block)) return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void testResting(){
+    VoxelGrid grid = makeGrid();
+    buildFloor(grid);
+
+    Aabb body = bodyAt(glm::vec3(0.0f, -0.5f, 0.0f));
+
+    SweepResult still = sweepAabb(grid, body, glm::vec3(0.0f));
+    check("resting/no_displacement", still.displacement == glm::vec3(0.0f) && !glm::any(still.hit));
+
+    // Gravity pulls a resting box into the floor every tick
+    SweepResult pulled = sweepAabb(grid, body, glm::vec3(0.0f, -0.2f, 0.0f));
+    check("resting/gravity_stays_put", fabsf(pulled.displacement.y) < TOLERANCE && pulled.hit.y);
+}
+
+static void testLongFall(){
+    VoxelGrid grid = makeGrid();
+    buildFloor(grid);
+
+    // 1000 m in one step, from inside the grid and from far above it
+    float starts[] = {40.0f, 999.0f};
+
+    for (float start : starts) {
+        Aabb body = bodyAt(glm::vec3(0.25f, start, -0.75f));
+        SweepResult fall = sweepAabb(grid, body, glm::vec3(0.0f, -1000.0f, 0.0f));
+        float feet = body.min.y + fall.displacement.y;
+
+        char name[64];
+        snprintf(name, sizeof(name), "fall/from_%.0f_stops_on_surface", start);
+        check(name, fall.hit.y && fabsf(feet - -0.5f) < TOLERANCE);
+    }
+
+    // A tall fall and a long slide in the same step
+    Aabb body = bodyAt(glm::vec3(0.0f, 60.0f, 0.0f));
+    SweepResult fall = sweepAabb(grid, body, glm::vec3(17.0f, -1000.0f, -9.0f));
+    Aabb moved = {body.min + fall.displacement, body.max + fall.displacement};
+
+    check("fall/diagonal_no_tunnelling", fall.hit.y && !penetrates(grid, moved, TOLERANCE) && fabsf(moved.min.y - -0.5f) < TOLERANCE);
+}
+
+static void testWallSlide(){
+    VoxelGrid grid = makeGrid();
+    buildFloor(grid);
+
+    // Wall of the blocks at x = 5, its face at x = 4.5
+    for (int y = 0; y < 8; y++) {
+        for (int z = -32; z < 32; z++) grid.setBlock(glm::ivec3(5, y, z), stone);
+    }
+
+    Aabb body = bodyAt(glm::vec3(3.5f, -0.5f, 0.0f));
+
+    SweepResult slide = sweepAabb(grid, body, glm::vec3(2.0f, 0.0f, 3.0f));
+    check("slide/stops_at_wall", slide.hit.x && fabsf(body.max.x + slide.displacement.x - 4.5f) < TOLERANCE);
+    check("slide/keeps_tangential_motion", !slide.hit.z && slide.displacement.z == 3.0f);
+
+    // Against the wall and on the floor, gravity included
+    Aabb touching = bodyAt(glm::vec3(4.5f - 0.3f, -0.5f, 0.0f));
+    SweepResult pressed = sweepAabb(grid, touching, glm::vec3(0.5f, -0.2f, -2.5f));
+    check("slide/along_wall_on_floor", pressed.hit.x && pressed.hit.y && !pressed.hit.z &&
+          fabsf(pressed.displacement.x) < TOLERANCE && fabsf(pressed.displacement.y) < TOLERANCE &&
+          pressed.displacement.z == -2.5f);
+}
+
+// Random solid blocks, then boxes starting in free space moved by random
+// displacements; the results are written to "results"
+static bool runRandomSweeps(std::vector<glm::vec3>& results){
+    VoxelGrid grid = makeGrid();
+    std::mt19937 random(TEST_SEED);
+    std::uniform_int_distribution<int> coordinate(-24, 23);
+    std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> displacement(-25.0f, 25.0f);
+    std::uniform_real_distribution<float> extent(0.1f, 1.4f);
+
+    for (int i = 0; i < 20000; i++) grid.setBlock(glm::ivec3(coordinate(random), coordinate(random), coordinate(random)), stone);
+
+    bool clean = true;
+    results.clear();
+
+    while (results.size() < 5000) {
+        glm::vec3 center = glm::vec3(position(random), position(random), position(random));
+        glm::vec3 half = glm::vec3(extent(random), extent(random), extent(random));
+        Aabb box = {center - half, center + half};
+
+        // sweepAabb() lets boxes already inside a block out, so only boxes
+        // clear of every block are swept
+        if (penetrates(grid, box, 0.0f)) continue;
+
+        glm::vec3 step = glm::vec3(displacement(random), displacement(random), displacement(random));
+        SweepResult sweep = sweepAabb(grid, box, step);
+        Aabb moved = {box.min + sweep.displacement, box.max + sweep.displacement};
+
+        if (penetrates(grid, moved, TOLERANCE)) clean = false;
+
+        results.push_back(sweep.displacement);
+    }
+
+    return clean;
+}
+
+static void testRandomSweeps(){
+    std::vector<glm::vec3> first, second;
+
+    check("random/never_penetrates", runRandomSweeps(first));
+
+    runRandomSweeps(second);
+    check("random/deterministic", first.size() == second.size() &&
+          memcmp(first.data(), second.data(), first.size() * sizeof(glm::vec3)) == 0);
+}
+
+int main(){
+    testResting();
+    testLongFall();
+    testWallSlide();
+    testRandomSweeps();
+
+    printf("%d failure(s)\n", failures);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}